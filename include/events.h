@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/core.h"
+#include "time_units.h"
 #include "keyboard_inputs.h"
 #include "game/piece.h"
 
@@ -34,15 +35,18 @@ enum EventPropagation
 };
 
 
+// arrival: when the input was read, to measure the latency until it is displayed. 0 when unknown.
 struct EventUserInput
 {
     enum KeyInput input;
+    nsecond arrival;
 };
 
 
 struct EventMouseMoved
 {
     screenpos pos;
+    nsecond arrival;
 };
 
 
@@ -101,11 +105,12 @@ struct Event
 
 struct EventData {};
 
-#define EVENT_INPUT( _input )                   \
+#define EVENT_INPUT( _input, _arrival )         \
     ( (struct Event) {                          \
         .type = EventType_USER_INPUT,           \
         .userInput = (struct EventUserInput) {  \
-            .input = _input                     \
+            .input = _input,                    \
+            .arrival = _arrival                 \
         }                                       \
     } )
 
@@ -139,6 +144,8 @@ struct EventData {};
     } )
 
 typedef enum EventPropagation ( *EventTriggeredCb )( void *subscriber, struct Event const *event );
+// Called right before a subscriber handles an event (begin = true), and right after it (begin = false).
+typedef void ( *EventDispatchObserverCb )( void *subscriber, bool begin );
 
 bool event_register( void *subscriber, EventTriggeredCb const callback );
 void event_unregister( void *subscriber );
@@ -147,5 +154,13 @@ bool event_subscribe( void *subscriber, enum EventType events );
 bool event_subscribe_all( void *subscriber );
 void event_unsubscribe( void *subscriber, enum EventType events );
 void event_unsubscribe_all( void *subscriber );
+// Frees the subscriptions. Every subscriber is forgotten.
+void event_uninit( void );
 
 void event_trigger( struct Event const *event );
+// While an input event is dispatched, the time at which it was read: the events and requests its subscribers send
+// are its consequences. 0 otherwise.
+nsecond event_input_arrival( void );
+
+// Optional, only one at a time. NULL removes it.
+void event_set_dispatch_observer( EventDispatchObserverCb observer );
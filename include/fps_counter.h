@@ -2,14 +2,41 @@
 
 #include "core_types.h"
 #include "time_units.h"
+#include "frame_histogram.h"
 
 struct FPSCounter;
 
+// Parts of a frame, in the order of the main loop.
+enum FramePhase
+{
+    FramePhase_INPUT,
+    FramePhase_UI,
+    FramePhase_REFRESH,
+    // Waiting for the next frame. Recorded by fpscounter_frame().
+    FramePhase_PACING,
+
+    FramePhase_Count
+};
+
 struct FPSCounter *fpscounter_init( void );
 void fpscounter_uninit( struct FPSCounter *fpsCounter );
 struct FPSCounter *fpscounter_get_instance( void );
 
 u64 fpscounter_frame( struct FPSCounter *fpsCounter );
+// After the loop waited for something to do, instead of waiting for the end of the frame: the frame starting now
+// is the first of a new series, the next one is due a frame duration later.
+void fpscounter_resume( struct FPSCounter *fpsCounter );
+
+// Lowers the framerate until disabled again, for the next frames.
+void fpscounter_set_throttled( struct FPSCounter *fpsCounter, bool throttled );
+// Framerate of the frames while there is activity, and the terminal keeps up. See settings.h.
+void fpscounter_set_capped_framerate( struct FPSCounter *fpsCounter, u64 framerate );
+
+// Without activity for a while, the frames go down to an idle framerate. The next activity brings the capped
+// framerate back from the next frame.
+void fpscounter_on_activity( struct FPSCounter *fpsCounter );
+// HANDLE signaled on activity, the console input for instance. An idle frame ends as soon as it is.
+void fpscounter_wake_on( struct FPSCounter *fpsCounter, void *handle );
 
 void fpscounter_frame_begin( struct FPSCounter *fpsCounter );
 u64 fpscounter_frame_end( struct FPSCounter *fpsCounter );
@@ -17,3 +44,16 @@ u64 fpscounter_frame_end( struct FPSCounter *fpsCounter );
 nsecond fpscounter_elapsed_time( struct FPSCounter *fpsCounter );
 nsecond fpscounter_average_time( struct FPSCounter *fpsCounter );
 u64 fpscounter_average_framerate( struct FPSCounter *fpsCounter );
+
+// Over the last frames. How late a frame started compared to its deadline, and how late the timer woke the loop up.
+nsecond fpscounter_max_start_jitter( struct FPSCounter *fpsCounter );
+nsecond fpscounter_max_timer_overshoot( struct FPSCounter *fpsCounter );
+
+// The phase lasted since the end of the previous one, or since the frame began.
+void fpscounter_phase_end( struct FPSCounter *fpsCounter, enum FramePhase phase );
+
+// Since the start of the program. The frames exclude the time spent waiting for activity, see fpscounter_resume().
+struct FrameHistogram const *fpscounter_phase_histogram( struct FPSCounter *fpsCounter, enum FramePhase phase );
+struct FrameHistogram const *fpscounter_frame_histogram( struct FPSCounter *fpsCounter );
+// Writes the histograms of the frames and of each phase in a text file, for offline comparison.
+bool fpscounter_dump_histograms( struct FPSCounter *fpsCounter, char const *path );
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "core_types.h"
+#include "time_units.h"
+
+#include <stdio.h>
+
+// Log-linear histogram of durations: each power of two is split in FRAME_HISTOGRAM_SUB_BUCKETS linear buckets, so
+// that any duration is known within about 6%, from a few nanoseconds to a minute, in a fixed amount of memory.
+// Recording is O(1). The percentiles are the upper bound of the bucket they fall into.
+
+enum // Constants
+{
+    FRAME_HISTOGRAM_SUB_BUCKET_BITS = 4,
+    FRAME_HISTOGRAM_SUB_BUCKETS = 1 << FRAME_HISTOGRAM_SUB_BUCKET_BITS,
+    // Durations from 2^36 ns (about 68 s) are counted in the last bucket.
+    FRAME_HISTOGRAM_MAX_MAGNITUDE = 36,
+    FRAME_HISTOGRAM_NB_BUCKETS = ( FRAME_HISTOGRAM_MAX_MAGNITUDE - FRAME_HISTOGRAM_SUB_BUCKET_BITS + 1 ) * FRAME_HISTOGRAM_SUB_BUCKETS
+};
+
+struct FrameHistogram
+{
+    u32 counts[FRAME_HISTOGRAM_NB_BUCKETS];
+    u64 nbValues;
+    nsecond max;
+};
+
+// The usual figures of a histogram, in tenths of milliseconds as they are displayed.
+struct FrameHistogramTimes
+{
+    u32 p50;
+    u32 p99;
+    u32 max;
+};
+
+void frame_histogram_record( struct FrameHistogram *histogram, nsecond duration );
+void frame_histogram_reset( struct FrameHistogram *histogram );
+
+// percent in [0, 100]. 0 when nothing was recorded.
+nsecond frame_histogram_percentile( struct FrameHistogram const *histogram, u32 percent );
+nsecond frame_histogram_max( struct FrameHistogram const *histogram );
+u64 frame_histogram_count( struct FrameHistogram const *histogram );
+struct FrameHistogramTimes frame_histogram_times( struct FrameHistogram const *histogram );
+
+// One line per non empty bucket, "name,lower_ns,upper_ns,count", after a comment line with the percentiles.
+void frame_histogram_dump( struct FrameHistogram const *histogram, char const *name, FILE *file );
@@ -2,6 +2,7 @@
 
 #include "core/core.h"
 #include "terminal/terminal_colors.h"
+#include "terminal/terminal_character.h"
 
 
 enum PegId
@@ -64,9 +65,14 @@ struct Piece
 };
 
 
+// Rasterizes the sprites of every piece, before anything is drawn.
+void piece_init( void );
+
 void peg_write_1x1( screenpos pos, struct Peg peg );
 void peg_write_4x2( screenpos pos, struct Peg peg );
 void peg_write_6x3( screenpos pos, struct Peg peg, bool hovered );
+// Characters drawn by peg_write_4x2(), row by row.
+struct Character const *peg_sprite_4x2( struct Peg peg );
 
 void pin_write_1x1( screenpos pos, struct Pin pin );
 void pin_write_4x2( screenpos pos, struct Pin pin );
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "core_types.h"
+#include "frame_histogram.h"
+#include "requests.h"
+
+// Input to display latency: from the moment an input is read, to the end of the write of the first frame showing
+// what it changed. It is measured for each request sent while dispatching an input (see event_input_arrival()),
+// and recorded per request type.
+// Only the requests whose handling wrote to the screen (see term_damage_totals()) are measured. Such a request is given
+// the next frame sent, which holds its changes along with anything else drawn since. Changes delayed in a cosmetic
+// area aren't waited for, so the latency of a request only changing these areas is underestimated.
+
+// Damage counter before a request is handled, for input_latency_on_request().
+usize input_latency_damage_mark( void );
+// After the request was handled. arrival: when the input leading to the request was read.
+void input_latency_on_request( enum RequestType type, nsecond arrival, usize damageMark );
+// After each term_refresh(): the requests waiting for a frame are given the one just sent, and the ones whose frame
+// has been written are recorded.
+void input_latency_on_refresh( void );
+
+struct FrameHistogram const *input_latency_histogram( enum RequestType type );
+char const *input_latency_request_name( enum RequestType type );
+
+// Same format as the frame histograms, one histogram per request type. Same attribution as above: the latency of a
+// request is the one of the first frame sent after it damaged the screen.
+bool input_latency_dump_histograms( char const *path );
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "core_types.h"
+#include "time_units.h"
+
+// Reads the console inputs on a dedicated thread, as soon as they arrive rather than at the start of the next frame.
+// They are queued with their arrival time in a lock free ring, with the main thread as the only consumer. Once the
+// ring is full, the next inputs wait in the console queue.
+
+// Each waiter has its own auto-reset event, for a wait not to consume the wake of another one.
+enum InputSignal
+{
+    InputSignal_ACTIVITY,   // Main loop, waiting for something to do.
+    InputSignal_IDLE_FRAME, // Frame pacing, ending an idle frame early.
+
+    InputSignal_Count
+};
+
+struct _INPUT_RECORD;
+
+bool input_reader_start( void *inputHandle );
+void input_reader_stop( void );
+
+// HANDLE signaled each time inputs are queued, to wait for them.
+void *input_reader_signal_handle( enum InputSignal signal );
+
+// Inputs queued and not popped yet.
+usize input_reader_nb_pending( void );
+// index-th oldest queued input, with index < input_reader_nb_pending(). Valid until popped.
+struct _INPUT_RECORD const *input_reader_peek( usize index, nsecond *outArrival );
+// Releases the oldest queued input.
+void input_reader_pop( void );
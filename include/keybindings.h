@@ -31,6 +31,8 @@ enum KeyBinding
     KeyBinding_PREVIOUS,
     KeyBinding_NEXT,
 
+    KeyBinding_LATENCY_OVERLAY,
+
     KeyBinding_Count
 };
 
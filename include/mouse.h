@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/core.h"
+#include "time_units.h"
 
 typedef void ( *OnMouseMoveCallback ) ( screenpos pos );
 
@@ -15,4 +16,5 @@ bool mouse_init( void );
 // It would be x=0 and y=0 for the mouse position.
 // This function transform the mouse coordinates into screenpos to simplify its usage
 screenpos mouse_pos( void );
-void mouse_consume_event( struct _MOUSE_EVENT_RECORD const *mouseEvent );
+// arrival: when the event was read from the console.
+void mouse_consume_event( struct _MOUSE_EVENT_RECORD const *mouseEvent, nsecond arrival );
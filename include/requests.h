@@ -24,6 +24,8 @@ enum RequestType
     RequestType_PREVIOUS,
 
     RequestType_EXIT_APP,
+
+    RequestType_Count
 };
 
 enum RequestStatus
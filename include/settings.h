@@ -4,8 +4,17 @@
 
 #include "mastermind.h"
 
+enum // Constants
+{
+    Settings_MIN_CAPPED_FRAMERATE = 15,
+    Settings_MAX_CAPPED_FRAMERATE = 240
+};
+
 bool settings_init( void );
 
+// Applied right away to the FPS counter, which must be initialized first.
+bool settings_set_capped_framerate( usize framerate );
+
 /* All these setters will be internal, and settings will check request instead */
 bool settings_set_nb_turns( usize nbTurns );
 bool settings_set_nb_pieces_per_turn( usize nbPieces );
@@ -13,6 +22,7 @@ bool settings_set_game_experience( enum GameExperience gameExperience );
 bool settings_set_color_blind_mode( bool enabled );
 bool settings_set_duplicate_allowed( bool allowed );
 
+usize settings_get_capped_framerate( void );
 usize settings_get_nb_turns( void );
 usize settings_get_nb_pieces_per_turn( void );
 enum GameExperience settings_get_game_experience( void );
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "terminal/terminal_layer.h"
+#include "terminal/terminal_screen.h"
+
+// Used by the screen to composite the layers when building a frame.
+
+// Character of the top-most visible layer at pos. Returns false if pos only shows the screen buffer.
+bool term_layers_character_at( screenpos pos, struct Character *outCharacter );
+
+// The terminal moved whatever it displayed on these lines, including the layers.
+void term_layers_on_scroll( u16 top, u16 bottom, enum ScrollDirection direction, u16 nbLines );
+// The terminal may have lost what it displayed past its previous size.
+void term_layers_on_resize( void );
+
+void term_layers_destroy_all( void );
@@ -11,4 +11,17 @@ int term_sequence_reset_cursor_pos( utf16 *outBuffer, usize bufferSize );
 int term_sequence_set_properties( utf16 *outBuffer, usize bufferSize, byte properties );
 int term_sequence_set_color( utf16 *outBuffer, usize bufferSize, termcolor color );
 int term_sequence_set_style( utf16 *outBuffer, usize bufferSize, struct Style style );
+// Only toggles the attributes and colors that differ between the two styles, merged in a single sequence.
+// Nothing is written if both styles are the same.
+int term_sequence_set_style_delta( utf16 *outBuffer, usize bufferSize, struct Style from, struct Style to );
 int term_sequence_set_cursor_pos( utf16 *outBuffer, usize bufferSize, screenpos pos );
+
+// DECSTBM. Note that setting the margins also moves the cursor to the home position.
+int term_sequence_set_scroll_region( utf16 *outBuffer, usize bufferSize, u16 top, u16 bottom );
+int term_sequence_reset_scroll_region( utf16 *outBuffer, usize bufferSize );
+int term_sequence_scroll_up( utf16 *outBuffer, usize bufferSize, u16 nbLines );
+int term_sequence_scroll_down( utf16 *outBuffer, usize bufferSize, u16 nbLines );
+
+// DEC private mode 2026: the terminal holds the rendering until the end sequence is received.
+int term_sequence_begin_synchronized_update( utf16 *outBuffer, usize bufferSize );
+int term_sequence_end_synchronized_update( utf16 *outBuffer, usize bufferSize );
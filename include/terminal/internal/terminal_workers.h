@@ -0,0 +1,16 @@
+#pragma once
+
+#include "core_types.h"
+
+// A few threads waiting to share the work of a frame with the thread calling term_refresh().
+
+typedef void ( *TermJobCb )( void *context, usize jobIdx );
+
+bool term_workers_start( usize nbWorkers );
+void term_workers_stop( void );
+
+usize term_workers_count( void );
+
+// Job 0 runs on the calling thread, the next ones on the workers. Returns once all of them are done.
+// There can't be more jobs than workers + 1.
+void term_workers_run( TermJobCb job, void *context, usize nbJobs );
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "terminal/terminal_screen.h"
+
+// Writes the frames on a dedicated thread, so that a slow terminal doesn't block the main loop.
+// One frame can wait while another one is being written. Nothing else is queued: as long as a frame is waiting,
+// the screen doesn't build new ones and keeps their changes for the first frame built afterwards.
+
+bool term_writer_start( TermOutputCb outputCb );
+// The frames already submitted are written before the thread stops.
+void term_writer_stop( void );
+
+// True while the last submitted frame hasn't been picked up by the writer.
+bool term_writer_is_behind( void );
+// The frame must stay untouched until the writer picked up the next one.
+void term_writer_submit( utf16 const *frame, usize size );
+
+struct TermFrameStats term_writer_last_frame_stats( void );
+// Incremented on each frame written. When it changed, the stats above are a new measure.
+usize term_writer_nb_frames_written( void );
+// When the write of the frameIndex-th frame submitted ended, 0 once out of the TERM_WRITE_TIMES_HISTORY last ones.
+// The frame must have been written already.
+nsecond term_writer_frame_written_time( usize frameIndex );
@@ -4,11 +4,15 @@
 #include "terminal/terminal_screen.h"
 #include "terminal/terminal_style.h"
 #include "terminal/terminal_character.h"
+#include "terminal/terminal_layer.h"
 
 
 bool term_init( char const *optTitle, bool onDedicatedConsole );
+// Frames are sent to the in-memory virtual terminal (see terminal_vt.h) instead of the console.
+bool term_init_headless( screensize size );
 void term_uninit( void );
 bool term_is_init( void );
+bool term_is_headless( void );
 
 bool term_set_title( char const *title );
 
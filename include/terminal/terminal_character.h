@@ -1,16 +1,17 @@
 #pragma once
 
+#include "terminal/terminal_glyph.h"
 #include "terminal/terminal_style.h"
 
 struct Character
 {
-    utf16 unicode;
+    termglyph glyph;
     struct Style style;
 };
 static_assert( sizeof( struct Character ) == 4 );
 
 
-struct Character character_make( utf16 unicode, struct Style style );
+struct Character character_make( termglyph glyph, struct Style style );
 struct Character character_default( void );
 
 bool character_equals( struct Character lhs, struct Character rhs );
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "core_types.h"
+
+// What a cell displays, in 16 bits so that a character still fits in 4 bytes.
+// A glyph made of a single UTF-16 code unit, outside of the surrogates, is its own ID: L'a' is a valid termglyph.
+// The other ones (surrogate pairs, and the combining marks following a base) are interned in a table, and given
+// an ID within the surrogates range. Their code units are kept there, ready to be copied in a frame.
+typedef u16 termglyph;
+
+enum // Constants
+{
+    GLYPH_FIRST_INTERNED = 0xD800,
+    GLYPH_MAX_INTERNED = 2047,
+    // Code units kept for an interned glyph. Combining marks past this limit are dropped.
+    GLYPH_MAX_UNITS = 8,
+
+    // Second cell covered by a wide glyph. It is never written to the terminal, the first cell is.
+    GLYPH_WIDE_TAIL = 0xDFFF,
+    // Shown instead of what can't be displayed: lone surrogates, or glyphs that didn't fit in the table.
+    GLYPH_REPLACEMENT = 0xFFFD
+};
+
+
+// Needed before any width is requested. Interned glyphs are kept until the program exits.
+void glyph_table_init( void );
+
+termglyph glyph_intern( utf16 const *units, usize nbUnits );
+// Reads the glyph at the beginning of the text: a code unit or a surrogate pair, with the combining marks following it.
+// Returns the number of code units read.
+usize glyph_decode( utf16 const *text, usize size, termglyph *outGlyph );
+
+// Number of cells covered by the glyph, 1 or 2.
+usize glyph_width( termglyph glyph );
+bool glyph_is_combining( utf16 unit );
+
+// Writes the code units of the glyph in outBuffer, that can hold GLYPH_MAX_UNITS of them. Returns how many were written.
+usize glyph_encode( termglyph glyph, utf16 *outBuffer );
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "core_types.h"
+#include "core_unions.h"
+
+#include "terminal/terminal_character.h"
+
+// Layers are composited over the screen buffer, which is the base layer all the widgets write into.
+// Their content is never written in the buffer: hiding or moving a layer brings back what is under it, and the
+// buffer can still be updated below a layer meanwhile. Only the cells covered by a layer before and after a change
+// are written again on the next refresh.
+
+enum // Constants
+{
+    TERM_MAX_LAYERS = 8
+};
+
+
+// From the bottom to the top. Layers with the same depth are stacked in their creation order.
+enum TermLayerDepth
+{
+    TermLayerDepth_MODAL,
+    TermLayerDepth_TOOLTIP,
+    TermLayerDepth_CURSOR
+};
+
+
+struct TermLayer;
+
+
+// The layer is hidden and blank at creation.
+struct TermLayer *term_layer_create( vec2u16 size, enum TermLayerDepth depth );
+void term_layer_destroy( struct TermLayer *layer );
+
+// Characters given row by row, size.w * size.h of them.
+void term_layer_set_content( struct TermLayer *layer, struct Character const *characters );
+void term_layer_move( struct TermLayer *layer, screenpos ul );
+
+void term_layer_show( struct TermLayer *layer );
+void term_layer_hide( struct TermLayer *layer );
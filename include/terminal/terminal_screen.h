@@ -2,26 +2,155 @@
 
 #include "core_types.h"
 #include "core_unions.h"
+#include "time_units.h"
+
+#include "terminal/terminal_character.h"
 
 enum // Constants
 {
-    // Maximum supported size of the generated content in a single call of term_write() / term_refresh().
+    // Maximum supported size of the generated content in a single call of term_write().
     TERM_WRITE_BUFFER_SIZE = 256,
-    TERM_REFRESH_BUFFER_SIZE = 16192
+    // Initial size of the frame sent by term_refresh(), grown when needed.
+    TERM_REFRESH_BUFFER_SIZE = 16192,
+    // Worst case for a single character: cursor position + style + glyph, and the sequences ending a frame.
+    TERM_REFRESH_CHARACTER_MAX_SIZE = 64 + GLYPH_MAX_UNITS,
+    TERM_REFRESH_FOOTER_MAX_SIZE = 32,
+
+    // Maximum number of scrolls that can be sent by the terminal in a single frame.
+    // Past this limit, the content is still shifted but the whole area will be written again.
+    TERM_MAX_SCROLLS_PER_FRAME = 8,
+
+    // Areas whose updates can be delayed when the terminal can't keep up. See term_add_cosmetic_area().
+    TERM_MAX_COSMETIC_AREAS = 8,
+    // While the link is saturated, cosmetic areas are only sent once every N frames.
+    TERM_COSMETIC_FRAME_INTERVAL = 10,
+
+    // A write slower than this means that the terminal doesn't keep up with our frame rate.
+    TERM_LINK_SLOW_WRITE_MSEC = 12,
+    // Refreshes in a row with a backlog or a slow write before the link is considered saturated, and refreshes in a
+    // row without any before it is considered clear again.
+    TERM_LINK_SATURATION_THRESHOLD = 4,
+    TERM_LINK_RECOVERY_THRESHOLD = 60,
+    // Frames whose write time is kept, see term_frame_written_time().
+    TERM_WRITE_TIMES_HISTORY = 8,
+
+    // Distinct damaged spans kept per line before the closest ones are merged.
+    TERM_MAX_DAMAGE_SPANS_PER_ROW = 4,
+    // Owners the damage can be counted for, see term_damage_set_owner(). 0 is for damage without any owner.
+    TERM_MAX_DAMAGE_OWNERS = 16,
+
+    // Threads encoding a frame, the one calling term_refresh() included.
+    TERM_MAX_ENCODERS = 4,
+    // Damaged characters in a frame before its lines are split between the encoding threads.
+    TERM_PARALLEL_ENCODE_MIN_CHARACTERS = 8192
+};
+
+
+enum ScrollDirection
+{
+    ScrollDirection_UP,  // The content goes up, the cleared lines appear at the bottom of the area.
+    ScrollDirection_DOWN // The content goes down, the cleared lines appear at the top of the area.
+};
+
+struct TermFrameStats
+{
+    usize bytesWritten;
+    usize nbSyscalls;
+    usize nbDroppedFrames; // Refreshes skipped just before this frame, as the writer was still busy with the previous ones.
+    nsecond writeDuration;
+};
+
+
+// Area reported as modified, with the number of characters in it.
+struct TermDamageTotals
+{
+    usize nbRects;
+    usize nbCells;
+};
+
+
+// Hands a complete frame over to whatever displays it (the console, or the headless virtual terminal).
+// Called once per non-empty frame from term_refresh().
+typedef struct TermFrameStats ( *TermOutputCb )( utf16 const *frame, usize size );
+
+
+struct TermOutput
+{
+    TermOutputCb outputCb;
+    bool synchronizedUpdate;
+    // Frames are written by a dedicated thread. While it is busy, refreshes are skipped and their changes are
+    // sent with the next frame instead.
+    bool async;
+    // Threads sharing the encoding of large frames, TERM_MAX_ENCODERS at most. 0 or 1 to encode them on the thread
+    // calling term_refresh(). The frames are the same either way.
+    usize nbEncoders;
 };
 
-bool term_screen_init( void const *handle );
+
+bool term_screen_init( screensize size, struct TermOutput output );
+void term_screen_uninit( void );
 
 // Write/clear won't have any impact on the content displayed until refresh is called.
 int term_write( utf16 const *format, ... );
 void term_clear( void );
 void term_refresh( void );
 
+// Unformatted writes, straight into the screen buffer. Anything out of the screen is clipped.
+// A run is written at pos with the given style, then the cursor is moved right after it, as term_write() does.
+// n is a number of UTF-16 code units, see terminal_glyph.h. Returns the number of cells written, wide glyphs
+// covering two of them.
+usize term_put_run( screenpos pos, struct Style style, utf16 const *text, usize n );
+// Fill and blit don't use or move the cursor. The blitted characters are given row by row, size.w * size.h of them.
+void term_fill( screenpos ul, vec2u16 size, struct Character character );
+void term_blit( screenpos ul, vec2u16 size, struct Character const *characters );
+
+// The characters of the area are written again on the next refresh, even if they didn't change in the buffer.
+void term_invalidate_area( screenpos ul, vec2u16 size );
+
+// Every write damages the area it changed. The damage of a frame is kept as a few spans per line, and the
+// refresh only visits these spans instead of the whole screen.
+// The damage added from now on is counted for this owner, for profiling. Returns the previous owner.
+u8 term_damage_set_owner( u8 owner );
+// Since the initialization or the last reset.
+struct TermDamageTotals term_damage_totals( u8 owner );
+void term_damage_reset_totals( void );
+
+// Shifts the content of an area by nbLines, both in the screen buffer and in the terminal.
+// The shift is done by the terminal itself on the next refresh, so only the cleared lines need to be written again.
+void term_scroll( screenpos ul, vec2u16 size, enum ScrollDirection direction, u16 nbLines );
+
 void term_on_resize( screensize newSize );
 
+// Content that is nice to have but not essential (statistics, timers, ...). When the terminal can't keep up with
+// the frames, the changes in these areas are delayed and merged, leaving the bandwidth to the rest of the screen.
+void term_add_cosmetic_area( screenpos ul, vec2u16 size );
+void term_remove_cosmetic_area( screenpos ul, vec2u16 size );
+
 
 
 // Getters
 screensize term_size( void );
 
+// True when the writes are too slow or late for the frames produced, until they have been fine for a while.
+// The frame rate should be lowered meanwhile.
+bool term_is_link_saturated( void );
+// True when changes couldn't be sent with the last frame, delayed or waiting for the writer: term_refresh() has to be
+// called again, even if nothing else changes.
+bool term_has_pending_changes( void );
+
 struct Character term_character_buffered_at_pos( screenpos pos );
+// What the terminal displays at pos once refreshed: the buffered character, or the layer covering it.
+// See terminal_layer.h. Half of a wide glyph, cut by a layer or the edge of the screen, shows up blank.
+// The refresh state is the one of the buffered character.
+struct Character term_character_composited_at_pos( screenpos pos );
+
+// Frames sent to the terminal since the start, including the ones still being written. Empty frames aren't sent:
+// when it increased, the last term_refresh() sent the frame term_nb_frames_sent() - 1.
+usize term_nb_frames_sent( void );
+// When the write of a frame sent (see above) ended. False while it isn't written yet. A frame older than the last
+// TERM_WRITE_TIMES_HISTORY ones written reads as written at 0.
+bool term_frame_written_time( usize frameIndex, nsecond *outTime );
+
+// Output cost of the last frame sent to the terminal. Empty frames aren't sent, so they aren't taken into account.
+// With an asynchronous output, it is the last frame that the writer has finished writing.
+struct TermFrameStats term_last_frame_stats( void );
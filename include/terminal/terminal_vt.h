@@ -0,0 +1,44 @@
+#pragma once
+
+#include "core_types.h"
+#include "core_unions.h"
+
+#include "terminal/terminal_character.h"
+
+// In-memory virtual terminal, interpreting the exact sequences sent by term_refresh() instead of a real console.
+// It allows the whole UI to run headless, and to check what a terminal would display against the screen buffer.
+// Only what the renderer can emit is understood: cursor position, SGR, scroll margins, scrolls and private modes.
+
+struct VTStats
+{
+    usize nbFeeds;       // One per frame received.
+    usize bytesFed;
+    usize cellsWritten;  // Printable characters, whether they changed the cell or not.
+    usize nbSequences;
+    usize nbUnknownSequences;
+};
+
+
+bool vt_init( screensize size );
+void vt_uninit( void );
+
+void vt_feed( utf16 const *data, usize size );
+
+// Content that is still in the new size is kept, the rest of it is blank.
+bool vt_resize( screensize size );
+
+// Number of visible cells where the virtual terminal doesn't display what the screen buffer holds, with the layers
+// composited over it.
+// Cells still waiting for a refresh are counted as well, so it is only meaningful right after term_refresh().
+usize vt_count_mismatches( void );
+
+// Getters
+screensize vt_size( void );
+screenpos vt_cursor_pos( void );
+struct Style vt_style( void );
+bool vt_in_synchronized_update( void );
+
+struct Character vt_character_at( screenpos pos );
+
+struct VTStats vt_stats( void );
+void vt_reset_stats( void );
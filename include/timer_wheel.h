@@ -0,0 +1,47 @@
+#pragma once
+
+#include "core_types.h"
+#include "time_units.h"
+
+// Hierarchical timer wheel: callbacks scheduled at a deadline, run by timer_wheel_advance() once it is past.
+// Scheduling and cancelling are O(1), whatever the number of timers. The deadlines are rounded up to the
+// millisecond, a callback never runs early.
+// The timers are owned by the caller, usually embedded in a widget: nothing is allocated. A timer must be
+// cancelled before it is freed.
+
+typedef void ( *TimerCallback )( void *userData, nsecond now );
+// Called right before a timer callback runs (begin = true), and right after it (begin = false).
+typedef void ( *TimerDispatchObserverCb )( void *userData, bool begin );
+
+struct Timer
+{
+    // Internal to the wheel.
+    struct Timer *prev;
+    struct Timer *next;
+    u64 expiresTick;
+    // expiresTick, unless it is beyond the range of the wheel.
+    u64 slotTick;
+    u8 level;
+    u8 slot;
+    bool scheduled;
+
+    TimerCallback callback;
+    void *userData;
+};
+
+// Starts counting from now. Timers scheduled before are lost.
+void timer_wheel_init( void );
+
+// Replaces the previous deadline if the timer was already scheduled. A deadline already past runs on the next
+// advance: when scheduled from a callback, not during the advance running it, even if it has more ticks to go through.
+void timer_wheel_schedule( struct Timer *timer, nsecond deadline, TimerCallback callback, void *userData );
+void timer_wheel_cancel( struct Timer *timer );
+bool timer_wheel_is_scheduled( struct Timer const *timer );
+
+// Runs the callbacks of every timer due by now, in the order of their deadlines to the millisecond.
+void timer_wheel_advance( nsecond now );
+// Earliest time at which a callback will run, 0 when no timer is scheduled.
+nsecond timer_wheel_next_deadline( void );
+
+// Optional, only one at a time. NULL removes it.
+void timer_wheel_set_dispatch_observer( TimerDispatchObserverCb observer );
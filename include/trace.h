@@ -0,0 +1,31 @@
+#pragma once
+
+#include "core_types.h"
+
+// Scoped tracing, exported in the Chrome trace event format (chrome://tracing or ui.perfetto.dev), to see which
+// part of a frame took the time. Only compiled with TRACE defined (make TRACE=1): otherwise the macros expand to
+// nothing and nothing is recorded.
+// Each thread records its scopes in its own ring buffer. Once it is full, the oldest scopes are overwritten.
+// Names aren't copied, they must live until the trace is flushed: string literals, widget names, ...
+
+#ifdef TRACE
+
+void trace_begin( char const *name );
+// Ends the last scope begun on this thread.
+void trace_end( void );
+
+// Writes the scopes recorded so far by every thread as a JSON trace. The other threads must not be recording
+// meanwhile: call it from the main loop, between two frames.
+bool trace_flush( char const *path );
+
+#define TRACE_BEGIN( _name ) trace_begin( _name )
+#define TRACE_END()          trace_end()
+#define TRACE_FLUSH( _path ) trace_flush( _path )
+
+#else
+
+#define TRACE_BEGIN( _name ) ( (void)0 )
+#define TRACE_END()          ( (void)0 )
+#define TRACE_FLUSH( _path ) ( (void)( _path ) )
+
+#endif
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "core/core.h"
+#include "terminal/terminal_screen.h"
+#include "time_units.h"
 
 
 enum UIScene
@@ -17,4 +19,17 @@ bool ui_init( void );
 void ui_uninit( void );
 
 void ui_frame( void );
+// Earliest timestamp at which an enabled widget changes by itself, 0 if none of them will. Until then, the screen
+// only changes in response to an input.
+nsecond ui_next_update_time( void );
 bool ui_change_scene( enum UIScene scene );
+
+struct UIWidgetDamage
+{
+    char const *name;
+    struct TermDamageTotals totals;
+};
+
+// Damage reported by each widget since the terminal damage totals were reset, for profiling.
+// Returns the number of widgets written in outDamage.
+usize ui_get_widgets_damage( struct UIWidgetDamage *outDamage, usize capacity );
@@ -6,6 +6,7 @@ struct Widget;
 
 typedef void ( * WidgetEnableCb )( struct Widget *widget );
 typedef void ( * WidgetDisableCb )( struct Widget *widget );
+// Widgets changing with time rather schedule a timer for their next change, see timer_wheel.h.
 typedef void ( * WidgetFrameCb )( struct Widget *widget );
 
 struct Widget
@@ -29,3 +30,4 @@ struct Widget *widget_timer_create( void );
 struct Widget *widget_peg_selector_create( void );
 struct Widget *widget_game_board_create( void );
 struct Widget *widget_peg_tracking_create( void );
+struct Widget *widget_input_latency_create( void );
@@ -0,0 +1,400 @@
+// Render benchmark: replays scripted game sessions on the headless terminal and measures ui_frame() + term_refresh().
+// Each scenario prints a single JSON object on stdout, so that the results of two builds can be compared.
+// The characters damaged by each widget during the scenario are reported along with the frame costs.
+#include "core/core.h"
+#include "mastermind.h"
+#include "mouse.h"
+#include "gameloop.h"
+#include "settings.h"
+#include "keybindings.h"
+#include "ui/ui.h"
+#include "events.h"
+#include "requests.h"
+#include "game/piece.h"
+#include "time_units.h"
+
+#include "terminal/terminal.h"
+#include "terminal/terminal_vt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+
+enum ExitCode
+{
+    ExitCode_SUCCESS,
+    ExitCode_FAILURE
+};
+
+
+enum // Constants
+{
+    BENCH_SEED = 0x6D6D,
+    BENCH_ITERATIONS = 5,
+    BENCH_INITIAL_SAMPLES = 4096,
+
+    BENCH_HISTORY_TURNS = 12,
+    BENCH_HISTORY_SCROLLS = 16,
+    BENCH_MOUSE_SWEEPS = 8,
+    BENCH_RESIZE_ROUNDS = 8,
+
+    BENCH_MAX_WIDGETS = 16
+};
+
+static screensize const S_BENCH_SIZE = { .w = 120, .h = 30 };
+
+static screensize const S_RESIZE_STEPS[] =
+{
+    { .w = 100, .h = 25 },
+    { .w = 160, .h = 45 },
+    { .w = 80,  .h = 20 },
+    { .w = 140, .h = 40 },
+    { .w = 120, .h = 30 },
+};
+
+
+struct FrameSample
+{
+    nsecond duration;
+    usize bytes;
+    usize cells;
+};
+
+
+struct BenchRun
+{
+    struct FrameSample *samples;
+    usize count;
+    usize capacity;
+
+    usize nbMismatches; // Cells where the virtual terminal doesn't show the buffer after a frame. Must stay at 0.
+};
+
+
+struct Scenario
+{
+    char const *name;
+    void ( *play )( struct BenchRun *run );
+};
+
+
+enum RequestStatus gameloop_on_request( struct Request const *req )
+{
+    // Nothing to stop, the scenarios decide when the session ends.
+    return ( req->type == RequestType_EXIT_APP ) ? RequestStatus_TREATED : RequestStatus_SKIPPED;
+}
+
+
+static void push_sample( struct BenchRun *const run, struct FrameSample const sample )
+{
+    if ( run->count == run->capacity )
+    {
+        usize const capacity = ( run->capacity == 0 ) ? BENCH_INITIAL_SAMPLES : run->capacity * 2;
+        struct FrameSample *const samples = realloc( run->samples, capacity * sizeof( struct FrameSample ) );
+        if ( !samples )
+        {
+            fprintf( stderr, "[ERROR]: Failed to allocate the bench samples.\n" );
+            exit( ExitCode_FAILURE );
+        }
+        run->samples = samples;
+        run->capacity = capacity;
+    }
+    run->samples[run->count++] = sample;
+}
+
+
+// A frame as done by the main loop, without the frame pacing.
+static void frame( struct BenchRun *const run )
+{
+    vt_reset_stats();
+
+    nsecond const begin = time_get_timestamp_nsec();
+    ui_frame();
+    term_refresh();
+    nsecond const end = time_get_timestamp_nsec();
+
+    struct VTStats const stats = vt_stats();
+    push_sample( run, (struct FrameSample) {
+        .duration = end - begin,
+        .bytes = stats.bytesFed,
+        .cells = stats.cellsWritten
+    } );
+    run->nbMismatches += vt_count_mismatches();
+}
+
+
+static void press( struct BenchRun *const run, enum KeyInput const input )
+{
+    struct Event const event = EVENT_INPUT( input, time_get_timestamp_nsec() );
+    event_trigger( &event );
+    frame( run );
+}
+
+
+static void move_mouse( struct BenchRun *const run, screenpos const pos )
+{
+    // The console reports positions starting at 0:0.
+    MOUSE_EVENT_RECORD const record = (MOUSE_EVENT_RECORD) {
+        .dwMousePosition = (COORD) { .X = pos.x - 1, .Y = pos.y - 1 },
+        .dwEventFlags = MOUSE_MOVED
+    };
+    mouse_consume_event( &record, time_get_timestamp_nsec() );
+    frame( run );
+}
+
+
+static void resize( struct BenchRun *const run, screensize const size )
+{
+    vt_resize( size );
+    term_on_resize( size );
+    frame( run );
+}
+
+
+// Distinct colors every turn, shifted so that the feedback changes. Never the solution, to play every turn.
+static void fill_guess( usize const turn, enum PegId *const outGuess, usize const nbPieces )
+{
+    struct Peg const *solution = mastermind_get_solution();
+
+    for ( usize shift = turn; ; ++shift )
+    {
+        bool isSolution = true;
+        for ( usize idx = 0; idx < nbPieces; ++idx )
+        {
+            outGuess[idx] = (enum PegId)( ( shift + idx ) % Mastermind_NB_COLORS );
+            isSolution = isSolution && ( solution[idx].id == outGuess[idx] );
+        }
+        if ( !isSolution ) return;
+    }
+}
+
+
+static void play_turn( struct BenchRun *const run )
+{
+    usize const nbPieces = mastermind_get_nb_pieces_per_turn();
+    enum PegId guess[nbPieces];
+    fill_guess( mastermind_get_player_turn(), guess, nbPieces );
+
+    for ( usize idx = 0; idx < nbPieces; ++idx )
+    {
+        enum KeyBinding const binding = (enum KeyBinding)( KeyBinding_PEG_BLACK + guess[idx] );
+        press( run, keybinding_get_binded_key( binding ) );
+        press( run, keybinding_get_binded_key( KeyBinding_NEXT ) );
+    }
+    press( run, keybinding_get_binded_key( Keybinding_CONFIRM_TURN ) );
+}
+
+
+static void start_new_game( struct BenchRun *const run )
+{
+    press( run, keybinding_get_binded_key( Keybinding_NEW_GAME ) );
+}
+
+
+// The next scenario starts a new game from the summary of this one.
+static void leave_game( struct BenchRun *const run )
+{
+    if ( !mastermind_is_game_finished() )
+    {
+        press( run, keybinding_get_binded_key( Keybinding_ABANDON_GAME ) );
+    }
+}
+
+
+static void play_full_game( struct BenchRun *const run )
+{
+    start_new_game( run );
+    while ( !mastermind_is_game_finished() )
+    {
+        play_turn( run );
+    }
+    leave_game( run );
+}
+
+
+static void play_history_scrolling( struct BenchRun *const run )
+{
+    start_new_game( run );
+    for ( usize turn = 0; turn < BENCH_HISTORY_TURNS; ++turn )
+    {
+        play_turn( run );
+    }
+
+    for ( usize idx = 0; idx < BENCH_HISTORY_SCROLLS; ++idx )
+    {
+        for ( usize step = 0; step < BENCH_HISTORY_TURNS; ++step ) press( run, keybinding_get_binded_key( KeyBinding_HISTORY_UP ) );
+        for ( usize step = 0; step < BENCH_HISTORY_TURNS; ++step ) press( run, keybinding_get_binded_key( KeyBinding_HISTORY_DOWN ) );
+    }
+    leave_game( run );
+}
+
+
+// Back and forth over the peg selector, one frame per cell crossed.
+static void play_mouse_sweeps( struct BenchRun *const run )
+{
+    start_new_game( run );
+    for ( usize sweep = 0; sweep < BENCH_MOUSE_SWEEPS; ++sweep )
+    {
+        for ( u16 y = 2; y <= 28; ++y )
+        {
+            u16 const x = ( sweep % 2 == 0 ) ? 2 + ( y % 12 ) : 14 - ( y % 12 );
+            move_mouse( run, SCREENPOS( x, y ) );
+        }
+        for ( u16 y = 28; y >= 2; --y )
+        {
+            move_mouse( run, SCREENPOS( 8, y ) );
+        }
+    }
+    move_mouse( run, SCREENPOS( 60, 15 ) );
+    leave_game( run );
+}
+
+
+static void play_resizes( struct BenchRun *const run )
+{
+    start_new_game( run );
+    play_turn( run );
+    for ( usize round = 0; round < BENCH_RESIZE_ROUNDS; ++round )
+    {
+        for ( usize idx = 0; idx < ARR_COUNT( S_RESIZE_STEPS ); ++idx )
+        {
+            resize( run, S_RESIZE_STEPS[idx] );
+        }
+    }
+    leave_game( run );
+}
+
+
+static struct Scenario const S_SCENARIOS[] =
+{
+    { .name = "full_game",          .play = play_full_game },
+    { .name = "history_scroll",     .play = play_history_scrolling },
+    { .name = "peg_selector_sweep", .play = play_mouse_sweeps },
+    { .name = "window_resize",      .play = play_resizes },
+};
+
+
+static int compare_durations( void const *lhs, void const *rhs )
+{
+    nsecond const a = *(nsecond const *)lhs;
+    nsecond const b = *(nsecond const *)rhs;
+    return ( a > b ) - ( a < b );
+}
+
+
+// Nearest-rank percentile of sorted durations.
+static nsecond percentile( nsecond const *sorted, usize const count, usize const percent )
+{
+    usize rank = ( percent * count + 99 ) / 100;
+    if ( rank == 0 ) rank = 1;
+    return sorted[rank - 1];
+}
+
+
+static void print_report( char const *name, struct BenchRun const *run )
+{
+    nsecond *durations = malloc( run->count * sizeof( nsecond ) );
+    if ( !durations )
+    {
+        fprintf( stderr, "[ERROR]: Failed to allocate the bench report.\n" );
+        exit( ExitCode_FAILURE );
+    }
+
+    nsecond totalDuration = 0;
+    usize totalBytes = 0;
+    usize totalCells = 0;
+    usize maxBytes = 0;
+    for ( usize idx = 0; idx < run->count; ++idx )
+    {
+        struct FrameSample const *sample = &run->samples[idx];
+        durations[idx] = sample->duration;
+        totalDuration += sample->duration;
+        totalBytes += sample->bytes;
+        totalCells += sample->cells;
+        maxBytes = max( maxBytes, sample->bytes );
+    }
+    qsort( durations, run->count, sizeof( nsecond ), compare_durations );
+
+    printf( "{\"scenario\":\"%s\",\"iterations\":%u,\"frames\":%zu,\"ns_per_frame\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu,"
+            "\"max_ns\":%llu,\"bytes_per_frame\":%.1f,\"max_bytes\":%zu,\"cells_per_frame\":%.1f,\"mismatches\":%zu,",
+        name, BENCH_ITERATIONS, run->count,
+        (unsigned long long)( totalDuration / run->count ),
+        (unsigned long long)percentile( durations, run->count, 50 ),
+        (unsigned long long)percentile( durations, run->count, 99 ),
+        (unsigned long long)durations[run->count - 1],
+        (double)totalBytes / run->count, maxBytes,
+        (double)totalCells / run->count,
+        run->nbMismatches );
+
+    // Characters damaged by each widget over the whole scenario.
+    struct UIWidgetDamage damage[BENCH_MAX_WIDGETS];
+    usize const nbWidgets = ui_get_widgets_damage( damage, ARR_COUNT( damage ) );
+    printf( "\"damaged_cells\":{" );
+    for ( usize idx = 0; idx < nbWidgets; ++idx )
+    {
+        printf( "%s\"%s\":%zu", ( idx > 0 ) ? "," : "", damage[idx].name, damage[idx].totals.nbCells );
+    }
+    printf( "}}\n" );
+
+    free( durations );
+}
+
+
+static bool init_systems( void )
+{
+    // Same solutions on every run, so that two builds replay exactly the same sessions.
+    srand( BENCH_SEED );
+
+    bool success = true;
+
+    success = success && term_init_headless( S_BENCH_SIZE );
+    piece_init();
+    success = success && settings_init();
+    success = success && mouse_init();
+    success = success && ui_init();
+
+    return success;
+}
+
+
+static void uninit_systems( void )
+{
+    ui_uninit();
+    term_uninit();
+}
+
+
+int main( void )
+{
+    if ( !init_systems() )
+    {
+        return ExitCode_FAILURE;
+    }
+
+    ui_change_scene( UIScene_MAIN_MENU );
+    struct BenchRun warmup = {};
+    frame( &warmup );
+    free( warmup.samples );
+
+    bool success = true;
+    for ( usize idx = 0; idx < ARR_COUNT( S_SCENARIOS ); ++idx )
+    {
+        struct BenchRun run = {};
+        term_damage_reset_totals();
+        for ( usize iteration = 0; iteration < BENCH_ITERATIONS; ++iteration )
+        {
+            S_SCENARIOS[idx].play( &run );
+        }
+
+        print_report( S_SCENARIOS[idx].name, &run );
+        success = success && run.nbMismatches == 0;
+        free( run.samples );
+    }
+
+    uninit_systems();
+    return success ? ExitCode_SUCCESS : ExitCode_FAILURE;
+}
@@ -1,10 +1,18 @@
 #include "events.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
 
 enum // Constants
 {
-    MAX_SUBSCRIBERS_COUNT = 16
+    INITIAL_SUBSCRIPTIONS_CAPACITY = 16,
+    // One per bit of EventType_MaskAll.
+    EVENT_TYPES_COUNT = 16
 };
 
+static_assert( EventType_MaskAll == ( 1 << EVENT_TYPES_COUNT ) - 1 );
+
 struct Subscription
 {
     void *subscriber;
@@ -12,14 +20,36 @@ struct Subscription
     enum EventType subscribedEvents;
 };
 
-static struct Subscription s_subscriptions[MAX_SUBSCRIBERS_COUNT];
+// Indices of the subscriptions to an event type, from the last one to the first: the order of dispatch.
+struct SubscriberList
+{
+    usize *indices;
+    usize count;
+    usize capacity;
+};
+
+// The index of a subscription is its priority: the last ones handle an event first. A freed subscription is reused
+// by the next subscriber registered.
+static struct Subscription *s_subscriptions = NULL;
+static usize s_nbSubscriptions = 0;
+static usize s_subscriptionsCapacity = 0;
+
+// Rebuilt from the subscriptions only when they changed, at the next event triggered.
+static struct SubscriberList s_subscriberLists[EVENT_TYPES_COUNT];
+static bool s_subscriberListsDirty = false;
+// Incremented at each rebuild, for a dispatch to notice that the lists changed under it.
+static u64 s_subscriberListsGeneration = 0;
+
+static EventDispatchObserverCb s_dispatchObserver = NULL;
+// Of the input event being dispatched, for what its subscribers trigger in turn.
+static nsecond s_inputArrival = 0;
 
 
 static struct Subscription *tryget_existing( void const *subscriber )
 {
     assert( subscriber );
 
-    for ( usize idx = 0; idx < MAX_SUBSCRIBERS_COUNT; ++idx )
+    for ( usize idx = 0; idx < s_nbSubscriptions; ++idx )
     {
         struct Subscription *sub = &s_subscriptions[idx];
         if ( sub->subscriber == subscriber )
@@ -33,7 +63,7 @@ static struct Subscription *tryget_existing( void const *subscriber )
 
 static struct Subscription *tryget_next_available( void )
 {
-    for ( usize idx = 0; idx < MAX_SUBSCRIBERS_COUNT; ++idx )
+    for ( usize idx = 0; idx < s_nbSubscriptions; ++idx )
     {
         struct Subscription *sub = &s_subscriptions[idx];
         if ( sub->subscriber == NULL )
@@ -42,13 +72,75 @@ static struct Subscription *tryget_next_available( void )
         }
     }
 
-    return NULL;
+    if ( s_nbSubscriptions == s_subscriptionsCapacity )
+    {
+        usize const newCapacity = ( s_subscriptionsCapacity > 0 ) ? s_subscriptionsCapacity * 2 : INITIAL_SUBSCRIPTIONS_CAPACITY;
+        struct Subscription *const newSubscriptions = realloc( s_subscriptions, newCapacity * sizeof( struct Subscription ) );
+        if ( !newSubscriptions )
+        {
+            fprintf( stderr, "[ERROR]: failed to allocate %zu event subscriptions.\n", newCapacity );
+            return NULL;
+        }
+        s_subscriptions = newSubscriptions;
+        s_subscriptionsCapacity = newCapacity;
+    }
+
+    struct Subscription *sub = &s_subscriptions[s_nbSubscriptions++];
+    *sub = (struct Subscription) {};
+    return sub;
 }
 
-static struct Subscription *tryget( void const *subscriber )
+
+static void set_subscribed_events( struct Subscription *sub, enum EventType const events )
 {
-    struct Subscription *sub = tryget_existing( subscriber );
-    return sub ? sub : tryget_next_available();
+    if ( sub->subscribedEvents == events ) return;
+
+    sub->subscribedEvents = events;
+    s_subscriberListsDirty = true;
+}
+
+
+static bool reserve_list( struct SubscriberList *list, usize const capacity )
+{
+    if ( capacity <= list->capacity ) return true;
+
+    usize newCapacity = ( list->capacity > 0 ) ? list->capacity : INITIAL_SUBSCRIPTIONS_CAPACITY;
+    while ( newCapacity < capacity ) newCapacity *= 2;
+
+    usize *const newIndices = realloc( list->indices, newCapacity * sizeof( usize ) );
+    if ( !newIndices ) return false;
+
+    list->indices = newIndices;
+    list->capacity = newCapacity;
+    return true;
+}
+
+
+static void rebuild_subscriber_lists( void )
+{
+    for ( usize type = 0; type < EVENT_TYPES_COUNT; ++type )
+    {
+        struct SubscriberList *list = &s_subscriberLists[type];
+        list->count = 0;
+        // Allocated for every subscription, not to fail halfway through.
+        if ( !reserve_list( list, s_nbSubscriptions ) )
+        {
+            fprintf( stderr, "[ERROR]: failed to allocate the subscribers to an event type.\n" );
+            continue;
+        }
+
+        for ( usize idx = s_nbSubscriptions; idx-- > 0; )
+        {
+            struct Subscription const *sub = &s_subscriptions[idx];
+            if ( sub->subscriber && ( sub->subscribedEvents & ( 1 << type ) ) )
+            {
+                list->indices[list->count++] = idx;
+            }
+        }
+    }
+
+    s_subscriberListsDirty = false;
+    s_subscriberListsGeneration += 1;
 }
 
 
@@ -79,19 +171,19 @@ void event_unregister( void *subscriber )
     struct Subscription *sub = tryget_existing( subscriber );
     if ( sub )
     {
+        set_subscribed_events( sub, EventType_MaskNone );
         sub->subscriber = NULL;
         sub->callback = NULL;
-        sub->subscribedEvents = EventType_MaskNone;
     }
 }
 
 
 bool event_subscribe( void *subscriber, enum EventType events )
 {
-    struct Subscription *sub = tryget( subscriber );
+    struct Subscription *sub = tryget_existing( subscriber );
     if ( sub )
     {
-        sub->subscribedEvents |= events;
+        set_subscribed_events( sub, sub->subscribedEvents | events );
         return true;
     }
     return false;
@@ -100,49 +192,120 @@ bool event_subscribe( void *subscriber, enum EventType events )
 
 bool event_subscribe_all( void *subscriber )
 {
-    struct Subscription *sub = tryget( subscriber );
-    if ( sub )
-    {
-        sub->subscribedEvents |= EventType_MaskAll;
-        return true;
-    }
-    return false;
+    return event_subscribe( subscriber, EventType_MaskAll );
 }
 
 
 void event_unsubscribe( void *subscriber, enum EventType const events )
 {
-    struct Subscription *sub = tryget( subscriber );
+    struct Subscription *sub = tryget_existing( subscriber );
     if ( sub )
     {
-        sub->subscribedEvents &= ~events;
+        set_subscribed_events( sub, sub->subscribedEvents & ~events );
     }
 }
 
 
 void event_unsubscribe_all( void *subscriber )
 {
-    struct Subscription *sub = tryget( subscriber );
+    struct Subscription *sub = tryget_existing( subscriber );
     if ( sub )
     {
-        sub->subscribedEvents = EventType_MaskNone;
+        set_subscribed_events( sub, EventType_MaskNone );
     }
 }
 
 
+void event_uninit( void )
+{
+    for ( usize type = 0; type < EVENT_TYPES_COUNT; ++type )
+    {
+        free( s_subscriberLists[type].indices );
+        s_subscriberLists[type] = (struct SubscriberList) {};
+    }
+    free( s_subscriptions );
+    s_subscriptions = NULL;
+    s_nbSubscriptions = 0;
+    s_subscriptionsCapacity = 0;
+    s_subscriberListsDirty = false;
+}
+
+
+static nsecond input_arrival_of( struct Event const *event )
+{
+    if ( event->type == EventType_USER_INPUT ) return event->userInput.arrival;
+    if ( event->type == EventType_MOUSE_MOVED ) return event->mouseMoved.arrival;
+    return 0;
+}
+
+
+// Position in the list of the first subscription dispatched after the one at the given index.
+static usize list_position_after( struct SubscriberList const *list, usize const index )
+{
+    usize position = 0;
+    while ( position < list->count && list->indices[position] >= index ) position += 1;
+    return position;
+}
+
+
 void event_trigger( struct Event const *event )
 {
     assert( event );
+    // A single type per event: it picks the list of its subscribers.
+    assert( event->type != EventType_MaskNone && ( event->type & ( event->type - 1 ) ) == 0 );
+    TRACE_BEGIN( "event_trigger" );
 
-    for ( int idx = MAX_SUBSCRIBERS_COUNT - 1; idx >= 0; --idx )
+    nsecond const previousInputArrival = s_inputArrival;
+    nsecond const inputArrival = input_arrival_of( event );
+    if ( inputArrival != 0 ) s_inputArrival = inputArrival;
+
+    if ( s_subscriberListsDirty ) rebuild_subscriber_lists();
+
+    usize const type = __builtin_ctz( event->type );
+    u64 generation = s_subscriberListsGeneration;
+    usize position = 0;
+    while ( position < s_subscriberLists[type].count )
     {
-        struct Subscription *sub = &s_subscriptions[idx];
-        if ( !sub->subscriber || ( sub->subscribedEvents & event->type ) == 0 ) continue;
+        usize const index = s_subscriberLists[type].indices[position];
+        struct Subscription *sub = &s_subscriptions[index];
 
         assert( sub->callback );
         assert( sub->subscriber );
 
-        enum EventPropagation const propagate = sub->callback( sub->subscriber, event );
+        // Kept aside, the callback may unregister the subscriber.
+        void *const subscriber = sub->subscriber;
+        if ( s_dispatchObserver ) s_dispatchObserver( subscriber, true );
+        enum EventPropagation const propagate = sub->callback( subscriber, event );
+        if ( s_dispatchObserver ) s_dispatchObserver( subscriber, false );
+
         if ( propagate == EventPropagation_STOP ) break;
-    }    
+
+        // The callback may have changed the subscriptions, or triggered an event which rebuilt the lists: the
+        // dispatch goes on from the same priority, with the subscriptions as they are now.
+        if ( s_subscriberListsDirty ) rebuild_subscriber_lists();
+        if ( generation != s_subscriberListsGeneration )
+        {
+            generation = s_subscriberListsGeneration;
+            position = list_position_after( &s_subscriberLists[type], index );
+        }
+        else
+        {
+            position += 1;
+        }
+    }
+
+    s_inputArrival = previousInputArrival;
+    TRACE_END();
+}
+
+
+nsecond event_input_arrival( void )
+{
+    return s_inputArrival;
+}
+
+
+void event_set_dispatch_observer( EventDispatchObserverCb const observer )
+{
+    s_dispatchObserver = observer;
 }
@@ -1,6 +1,7 @@
 #include "fps_counter.h"
 
 #include <math.h>
+#include <stdio.h>
 //#include <time.h>
 #include <synchapi.h>
 #include <windows.h>
@@ -19,12 +20,28 @@ enum
     FRAMERATE_75_IN_NSEC  = Time_SEC_IN_NSEC / 75,
     FRAMERATE_60_IN_NSEC  = Time_SEC_IN_NSEC / 60,
     FRAMERATE_45_IN_NSEC  = Time_SEC_IN_NSEC / 45,
-    FRAMERATE_30_IN_NSEC  = Time_SEC_IN_NSEC / 30
+    FRAMERATE_30_IN_NSEC  = Time_SEC_IN_NSEC / 30,
+    FRAMERATE_10_IN_NSEC  = Time_SEC_IN_NSEC / 10,
+
+    // Without any activity for this long, the frames go down to the idle framerate.
+    IDLE_DELAY_NSEC = 2 * Time_SEC_IN_NSEC,
+
+    // The timer wakes the thread up this early at least, and the end of the wait is spent spinning.
+    MIN_SPIN_SLACK_NSEC = 50 * Time_USEC_IN_NSEC,
+    MAX_SPIN_SLACK_NSEC = 2 * Time_MSEC_IN_NSEC,
+    // Past the largest overshoot seen, to cover the ones slightly larger.
+    SPIN_SLACK_MARGIN_NSEC = 50 * Time_USEC_IN_NSEC,
+    // The slack goes back down by 1/64th per frame once the timer is more accurate.
+    SPIN_SLACK_DECAY_SHIFT = 6
 };
 
 struct FrameHistory
 {
     nsecond frameDuration[FRAME_HISTORY_COUNT];
+    // How late each frame started compared to its deadline.
+    nsecond startJitter[FRAME_HISTORY_COUNT];
+    // How late the timer woke the thread up, compared to what was asked. The spin slack has to cover it.
+    nsecond timerOvershoot[FRAME_HISTORY_COUNT];
     nsecond totalDuration;
     nsecond averageDuration;
     u8   frameIndex;
@@ -33,17 +50,106 @@ struct FrameHistory
 struct FPSCounter
 {
     HANDLE waitableTimer;
-    LARGE_INTEGER minWaitTimePerFrame100ns;
+    // Ends the wait of an idle frame early once signaled. See fpscounter_wake_on().
+    HANDLE wakeHandle;
+
+    // From the settings. The target is longer while throttled or idle.
+    nsecond cappedFrameDuration;
+    nsecond targetFrameDuration;
+    bool throttled;
+    bool idle;
+    nsecond lastActivity;
+
+    // Frames start at fixed steps from each other, not one frame duration after the previous frame ended.
+    // Otherwise the time spent waking up adds up and the framerate drifts below the target.
+    nsecond nextDeadline;
+    nsecond spinSlack;
 
     nsecond frameBegin;
     nsecond frameEnd;
+    nsecond phaseBegin;
 
     struct FrameHistory history;
+    struct FrameHistogram frameHistogram;
+    struct FrameHistogram phaseHistograms[FramePhase_Count];
+};
+
+
+static char const *const S_PHASE_NAMES[FramePhase_Count] =
+{
+    [FramePhase_INPUT]   = "input",
+    [FramePhase_UI]      = "ui",
+    [FramePhase_REFRESH] = "refresh",
+    [FramePhase_PACING]  = "pacing"
 };
 
 static struct FPSCounter s_fpsCounter = {}; // Just to avoid dynamic alloc
 
-static nsecond S_CAPPED_FRAMERATE = FRAMERATE_120_IN_NSEC;
+// Until the settings are applied.
+static nsecond S_DEFAULT_CAPPED_FRAMERATE = FRAMERATE_120_IN_NSEC;
+// Used instead of the capped framerate while throttled, when the terminal can't keep up.
+static nsecond S_THROTTLED_FRAMERATE = FRAMERATE_30_IN_NSEC;
+// Used instead of the capped framerate when nothing happened for a while.
+static nsecond S_IDLE_FRAMERATE = FRAMERATE_10_IN_NSEC;
+
+
+// The slowest of the framerates that apply.
+static void update_target_frame_duration( struct FPSCounter *fpsCounter )
+{
+    nsecond frameDuration = fpsCounter->cappedFrameDuration;
+    if ( fpsCounter->throttled ) frameDuration = max( frameDuration, S_THROTTLED_FRAMERATE );
+    if ( fpsCounter->idle ) frameDuration = max( frameDuration, S_IDLE_FRAMERATE );
+
+    fpsCounter->targetFrameDuration = frameDuration;
+}
+
+
+// Sleeps until the timer is due, writing how late it woke the thread up in outOvershoot.
+// Returns false when the wait was ended early by the wake handle.
+static bool sleep_until( struct FPSCounter *fpsCounter, nsecond const wakeUpTime, nsecond const now, nsecond *const outOvershoot )
+{
+    *outOvershoot = 0;
+
+    // Negative to be relative and not UTC. The deadline itself is absolute, on the monotonic clock.
+    LARGE_INTEGER dueTime100ns;
+    dueTime100ns.QuadPart = (i64)( ( wakeUpTime - now ) / 100 ) * -1;
+
+    if ( !SetWaitableTimerEx( fpsCounter->waitableTimer, &dueTime100ns, 0, NULL, NULL, NULL, 0 ) )
+    {
+        // The spin takes over, the frame is only paced less efficiently.
+        return true;
+    }
+
+    // Only the idle frames are long enough for a wait to be noticed.
+    if ( fpsCounter->idle && fpsCounter->wakeHandle )
+    {
+        HANDLE const handles[] = { fpsCounter->waitableTimer, fpsCounter->wakeHandle };
+        if ( WaitForMultipleObjects( ARR_COUNT( handles ), handles, FALSE, INFINITE ) == WAIT_OBJECT_0 + 1 )
+        {
+            CancelWaitableTimer( fpsCounter->waitableTimer );
+            return false;
+        }
+    }
+    else
+    {
+        WaitForSingleObject( fpsCounter->waitableTimer, INFINITE );
+    }
+
+    nsecond const wokenUp = time_get_timestamp_nsec();
+    *outOvershoot = ( wokenUp > wakeUpTime ) ? wokenUp - wakeUpTime : 0;
+    return true;
+}
+
+
+// Large enough for the timer overshoots seen recently, so that the frame never starts late because of them.
+static void calibrate_spin_slack( struct FPSCounter *fpsCounter, nsecond const overshoot )
+{
+    nsecond slack = fpsCounter->spinSlack;
+    slack -= slack >> SPIN_SLACK_DECAY_SHIFT;
+    slack = max( slack, overshoot + SPIN_SLACK_MARGIN_NSEC );
+
+    fpsCounter->spinSlack = min( max( slack, (nsecond)MIN_SPIN_SLACK_NSEC ), (nsecond)MAX_SPIN_SLACK_NSEC );
+}
 
 
 struct FPSCounter *fpscounter_init( void )
@@ -55,12 +161,17 @@ struct FPSCounter *fpscounter_init( void )
         return NULL;
     }
 
-    // - 1 ms for accuracy, otherwise we will be at 59fps instead of 60fps
-    // negative to be relative and not UTC.
-    fpsCounter->minWaitTimePerFrame100ns.QuadPart = (i64)( (u64)( S_CAPPED_FRAMERATE - Time_MSEC_IN_NSEC ) / (u64)100 ) * -1;
+    // The settings may have been applied already.
+    if ( fpsCounter->cappedFrameDuration == 0 ) fpsCounter->cappedFrameDuration = S_DEFAULT_CAPPED_FRAMERATE;
+    fpsCounter->throttled = false;
+    fpsCounter->idle = false;
+    update_target_frame_duration( fpsCounter );
 
-    SetWaitableTimerEx( fpsCounter->waitableTimer, &fpsCounter->minWaitTimePerFrame100ns, 0, NULL, NULL, NULL, 0 );
+    fpsCounter->spinSlack = MAX_SPIN_SLACK_NSEC;
     fpsCounter->frameBegin = time_get_timestamp_nsec();
+    fpsCounter->phaseBegin = fpsCounter->frameBegin;
+    fpsCounter->lastActivity = fpsCounter->frameBegin;
+    fpsCounter->nextDeadline = fpsCounter->frameBegin + fpsCounter->targetFrameDuration;
 
     return fpsCounter;
 }
@@ -91,30 +202,107 @@ u64 fpscounter_average_framerate( struct FPSCounter *fpsCounter )
 
 u64 fpscounter_frame( struct FPSCounter *fpsCounter )
 {
-    WaitForSingleObject( fpsCounter->waitableTimer, INFINITE );
+    nsecond deadline = fpsCounter->nextDeadline;
+    nsecond now = time_get_timestamp_nsec();
+    nsecond overshoot = 0;
 
-    do
+    // Sleep for most of the wait, and only spin for the end of it, the timer being too coarse to start the frame on time.
+    if ( now + fpsCounter->spinSlack < deadline )
+    {
+        if ( sleep_until( fpsCounter, deadline - fpsCounter->spinSlack, now, &overshoot ) )
+        {
+            calibrate_spin_slack( fpsCounter, overshoot );
+        }
+        else
+        {
+            // Something happened, the frame starts right away.
+            deadline = time_get_timestamp_nsec();
+        }
+        now = time_get_timestamp_nsec();
+    }
+    while ( now < deadline )
     {
-        fpsCounter->frameEnd = time_get_timestamp_nsec();
-    } while ( fpsCounter->frameEnd - fpsCounter->frameBegin < S_CAPPED_FRAMERATE );
+        YieldProcessor();
+        now = time_get_timestamp_nsec();
+    }
 
+    fpsCounter->frameEnd = now;
 	nsecond const delta = fpsCounter->frameEnd - fpsCounter->frameBegin;
 
     struct FrameHistory *history = &fpsCounter->history;
     history->totalDuration -= history->frameDuration[history->frameIndex];
     history->totalDuration += delta;
     history->frameDuration[history->frameIndex] = delta;
+    history->startJitter[history->frameIndex] = now - deadline;
+    history->timerOvershoot[history->frameIndex] = overshoot;
     history->frameIndex = ( history->frameIndex + 1 ) % FRAME_HISTORY_COUNT;
     history->averageDuration = history->totalDuration / FRAME_HISTORY_COUNT;
 
-    // Prepare the next frame
-    SetWaitableTimerEx( fpsCounter->waitableTimer, &fpsCounter->minWaitTimePerFrame100ns, 0, NULL, NULL, NULL, 0 );
+    frame_histogram_record( &fpsCounter->frameHistogram, delta );
+    frame_histogram_record( &fpsCounter->phaseHistograms[FramePhase_PACING], now - fpsCounter->phaseBegin );
+    fpsCounter->phaseBegin = now;
+
+    if ( !fpsCounter->idle && now - fpsCounter->lastActivity >= IDLE_DELAY_NSEC )
+    {
+        fpsCounter->idle = true;
+        update_target_frame_duration( fpsCounter );
+    }
+
+    // Prepare the next frame. A frame late by more than a whole frame doesn't make the next ones rush to catch up.
+    fpsCounter->nextDeadline = deadline + fpsCounter->targetFrameDuration;
+    if ( fpsCounter->nextDeadline <= now )
+    {
+        fpsCounter->nextDeadline = now + fpsCounter->targetFrameDuration;
+    }
 	fpsCounter->frameBegin = fpsCounter->frameEnd;
 
     return delta;
 }
 
 
+void fpscounter_resume( struct FPSCounter *fpsCounter )
+{
+    fpsCounter->frameBegin = time_get_timestamp_nsec();
+    fpsCounter->phaseBegin = fpsCounter->frameBegin;
+    fpsCounter->nextDeadline = fpsCounter->frameBegin + fpsCounter->targetFrameDuration;
+}
+
+
+void fpscounter_set_throttled( struct FPSCounter *fpsCounter, bool const throttled )
+{
+    if ( fpsCounter->throttled == throttled ) return;
+
+    fpsCounter->throttled = throttled;
+    update_target_frame_duration( fpsCounter );
+}
+
+
+void fpscounter_set_capped_framerate( struct FPSCounter *fpsCounter, u64 const framerate )
+{
+    assert( framerate > 0 );
+
+    fpsCounter->cappedFrameDuration = Time_SEC_IN_NSEC / framerate;
+    update_target_frame_duration( fpsCounter );
+}
+
+
+void fpscounter_wake_on( struct FPSCounter *fpsCounter, void *const handle )
+{
+    fpsCounter->wakeHandle = handle;
+}
+
+
+void fpscounter_on_activity( struct FPSCounter *fpsCounter )
+{
+    fpsCounter->lastActivity = time_get_timestamp_nsec();
+    if ( !fpsCounter->idle ) return;
+
+    // The next frame was scheduled at the idle framerate.
+    fpsCounter->idle = false;
+    update_target_frame_duration( fpsCounter );
+    fpsCounter->nextDeadline = min( fpsCounter->nextDeadline, fpsCounter->frameBegin + fpsCounter->targetFrameDuration );
+}
+
 
 u64 fpscounter_elapsed_time( struct FPSCounter *fpsCounter )
 {
@@ -127,3 +315,70 @@ u64 fpscounter_average_time( struct FPSCounter *fpsCounter )
     struct FrameHistory *history = &fpsCounter->history;
     return history->averageDuration;
 }
+
+
+nsecond fpscounter_max_start_jitter( struct FPSCounter *fpsCounter )
+{
+    struct FrameHistory *history = &fpsCounter->history;
+    nsecond jitter = 0;
+    for ( usize idx = 0; idx < FRAME_HISTORY_COUNT; ++idx )
+    {
+        jitter = max( jitter, history->startJitter[idx] );
+    }
+    return jitter;
+}
+
+nsecond fpscounter_max_timer_overshoot( struct FPSCounter *fpsCounter )
+{
+    struct FrameHistory *history = &fpsCounter->history;
+    nsecond overshoot = 0;
+    for ( usize idx = 0; idx < FRAME_HISTORY_COUNT; ++idx )
+    {
+        overshoot = max( overshoot, history->timerOvershoot[idx] );
+    }
+    return overshoot;
+}
+
+
+void fpscounter_phase_end( struct FPSCounter *fpsCounter, enum FramePhase const phase )
+{
+    assert( phase < FramePhase_Count );
+
+    nsecond const now = time_get_timestamp_nsec();
+    frame_histogram_record( &fpsCounter->phaseHistograms[phase], now - fpsCounter->phaseBegin );
+    fpsCounter->phaseBegin = now;
+}
+
+
+struct FrameHistogram const *fpscounter_phase_histogram( struct FPSCounter *fpsCounter, enum FramePhase const phase )
+{
+    assert( phase < FramePhase_Count );
+    return &fpsCounter->phaseHistograms[phase];
+}
+
+
+struct FrameHistogram const *fpscounter_frame_histogram( struct FPSCounter *fpsCounter )
+{
+    return &fpsCounter->frameHistogram;
+}
+
+
+bool fpscounter_dump_histograms( struct FPSCounter *fpsCounter, char const *const path )
+{
+    FILE *const file = fopen( path, "w" );
+    if ( !file )
+    {
+        fprintf( stderr, "[ERROR]: Failed to open %s to dump the frame histograms.\n", path );
+        return false;
+    }
+
+    fprintf( file, "phase,lower_ns,upper_ns,count\n" );
+    frame_histogram_dump( &fpsCounter->frameHistogram, "frame", file );
+    for ( usize idx = 0; idx < FramePhase_Count; ++idx )
+    {
+        frame_histogram_dump( &fpsCounter->phaseHistograms[idx], S_PHASE_NAMES[idx], file );
+    }
+
+    fclose( file );
+    return true;
+}
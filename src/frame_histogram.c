@@ -0,0 +1,122 @@
+#include "frame_histogram.h"
+
+#include <string.h>
+
+
+static usize bucket_index( nsecond const duration )
+{
+    if ( duration < FRAME_HISTOGRAM_SUB_BUCKETS ) return (usize)duration;
+
+    usize const magnitude = 63 - __builtin_clzll( duration );
+    if ( magnitude >= FRAME_HISTOGRAM_MAX_MAGNITUDE ) return FRAME_HISTOGRAM_NB_BUCKETS - 1;
+
+    // The sub bucket is given by the bits following the most significant one.
+    usize const shift = magnitude - FRAME_HISTOGRAM_SUB_BUCKET_BITS;
+    return ( shift + 1 ) * FRAME_HISTOGRAM_SUB_BUCKETS + (usize)( ( duration >> shift ) - FRAME_HISTOGRAM_SUB_BUCKETS );
+}
+
+
+static nsecond bucket_lower_bound( usize const index )
+{
+    if ( index < FRAME_HISTOGRAM_SUB_BUCKETS ) return index;
+
+    usize const shift = index / FRAME_HISTOGRAM_SUB_BUCKETS - 1;
+    return (nsecond)( FRAME_HISTOGRAM_SUB_BUCKETS + index % FRAME_HISTOGRAM_SUB_BUCKETS ) << shift;
+}
+
+
+static nsecond bucket_upper_bound( usize const index )
+{
+    if ( index < FRAME_HISTOGRAM_SUB_BUCKETS ) return index;
+
+    usize const shift = index / FRAME_HISTOGRAM_SUB_BUCKETS - 1;
+    return bucket_lower_bound( index ) + ( (nsecond)1 << shift ) - 1;
+}
+
+
+void frame_histogram_record( struct FrameHistogram *const histogram, nsecond const duration )
+{
+    histogram->counts[bucket_index( duration )] += 1;
+    histogram->nbValues += 1;
+    if ( duration > histogram->max ) histogram->max = duration;
+}
+
+
+void frame_histogram_reset( struct FrameHistogram *const histogram )
+{
+    memset( histogram, 0, sizeof( struct FrameHistogram ) );
+}
+
+
+nsecond frame_histogram_percentile( struct FrameHistogram const *const histogram, u32 const percent )
+{
+    assert( percent <= 100 );
+    if ( histogram->nbValues == 0 ) return 0;
+
+    // Rank of the value, rounded up: the p99 of 10 values is the largest one.
+    u64 rank = ( histogram->nbValues * percent + 99 ) / 100;
+    if ( rank == 0 ) rank = 1;
+
+    u64 seen = 0;
+    for ( usize idx = 0; idx < FRAME_HISTOGRAM_NB_BUCKETS; ++idx )
+    {
+        seen += histogram->counts[idx];
+        if ( seen >= rank )
+        {
+            nsecond const upper = bucket_upper_bound( idx );
+            return ( upper < histogram->max ) ? upper : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+
+nsecond frame_histogram_max( struct FrameHistogram const *const histogram )
+{
+    return histogram->max;
+}
+
+
+u64 frame_histogram_count( struct FrameHistogram const *const histogram )
+{
+    return histogram->nbValues;
+}
+
+
+static u32 to_tenth_of_msec( nsecond const duration )
+{
+    return (u32)( duration / ( Time_MSEC_IN_NSEC / 10 ) );
+}
+
+
+struct FrameHistogramTimes frame_histogram_times( struct FrameHistogram const *const histogram )
+{
+    return (struct FrameHistogramTimes) {
+        .p50 = to_tenth_of_msec( frame_histogram_percentile( histogram, 50 ) ),
+        .p99 = to_tenth_of_msec( frame_histogram_percentile( histogram, 99 ) ),
+        .max = to_tenth_of_msec( frame_histogram_max( histogram ) )
+    };
+}
+
+
+void frame_histogram_dump( struct FrameHistogram const *const histogram, char const *const name, FILE *const file )
+{
+    fprintf( file, "# %s: %llu values, p50 %llu ns, p90 %llu ns, p99 %llu ns, max %llu ns\n",
+        name,
+        (unsigned long long)histogram->nbValues,
+        (unsigned long long)frame_histogram_percentile( histogram, 50 ),
+        (unsigned long long)frame_histogram_percentile( histogram, 90 ),
+        (unsigned long long)frame_histogram_percentile( histogram, 99 ),
+        (unsigned long long)histogram->max );
+
+    for ( usize idx = 0; idx < FRAME_HISTOGRAM_NB_BUCKETS; ++idx )
+    {
+        if ( histogram->counts[idx] == 0 ) continue;
+
+        fprintf( file, "%s,%llu,%llu,%lu\n",
+            name,
+            (unsigned long long)bucket_lower_bound( idx ),
+            (unsigned long long)bucket_upper_bound( idx ),
+            (unsigned long)histogram->counts[idx] );
+    }
+}
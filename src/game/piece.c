@@ -62,121 +62,209 @@ static struct Style pin_style( struct Pin const pin )
 }
 
 
-void pin_write_1x1( screenpos const pos, struct Pin const pin )
+enum SpriteSize
+{
+    SpriteSize_1x1,
+    SpriteSize_4x2,
+    SpriteSize_6x3,
+
+    SpriteSize_Count
+};
+
+
+enum // Constants
 {
-    style_update( pin_style( pin ) );
-    cursor_update_yx( pos.y, pos.x );
+    SPRITE_MAX_WIDTH = 6,
+    SPRITE_MAX_HEIGHT = 3
+};
+
+
+// Pre-rasterized block of a piece, blitted as is on the screen.
+struct Sprite
+{
+    vec2u16 size;
+    struct Style style;
+    struct Character characters[SPRITE_MAX_WIDTH * SPRITE_MAX_HEIGHT];
+};
 
-    if ( pin.id == PinId_INCORRECT )
+
+static vec2u16 const S_SPRITE_SIZES[SpriteSize_Count] =
+{
+    [SpriteSize_1x1] = { .w = 1, .h = 1 },
+    [SpriteSize_4x2] = { .w = 4, .h = 2 },
+    [SpriteSize_6x3] = { .w = 6, .h = 3 },
+};
+
+
+static utf16 const *const S_FILLED_4X2[] = { L",db.",   L"`YP'" };
+static utf16 const *const S_FILLED_6X3[] = { L",d||b.", L"OOOOOO", L"`Y||P'" };
+static utf16 const *const S_EMPTY_PEG_4X2[] = { L".''.",   L"`,,'" };
+static utf16 const *const S_EMPTY_PEG_6X3[] = { L",:'':.", L":    :", L"`:,,:'" };
+static utf16 const *const S_EMPTY_PIN_4X2[] = { L"    ",   L"    " };
+static utf16 const *const S_EMPTY_PIN_6X3[] = { L"      ", L"      ", L"      " };
+
+
+// Indexed by [size][id][hidden][hovered] and [size][id][hovered].
+static struct Sprite s_pegSprites[SpriteSize_Count][PegId_Count][2][2];
+static struct Sprite s_pinSprites[SpriteSize_Count][PinId_Count][2];
+static bool s_spritesInitialized = false;
+
+
+static void rasterize_sprite( struct Sprite *const sprite, enum SpriteSize const size, struct Style const style, utf16 const *const *lines )
+{
+    sprite->size = S_SPRITE_SIZES[size];
+    sprite->style = style;
+
+    for ( usize y = 0; y < sprite->size.h; ++y )
     {
-        term_write( L" " );
-        return;
+        assert( lines[y][sprite->size.w] == L'\0' );
+        for ( usize x = 0; x < sprite->size.w; ++x )
+        {
+            sprite->characters[y * sprite->size.w + x] = character_make( lines[y][x], style );
+        }
     }
-    term_write( L"%lc", UTF16C_SmallFilledCircle );
 }
 
 
-void pin_write_4x2( screenpos const pos, struct Pin const pin )
+static utf16 const *const *peg_lines( enum SpriteSize const size, struct Peg const peg, utf16 const *const oneLine[] )
 {
-    style_update( pin_style( pin ) );
-    cursor_update_yx( pos.y, pos.x );
-
-    if ( pin.id == PinId_INCORRECT )
+    switch ( size )
     {
-        term_write( L"    " );
-        cursor_update_yx( pos.y + 1, pos.x );
-        term_write( L"    " );
-        return;
+        case SpriteSize_4x2: return ( peg.id == PegId_EMPTY ) ? S_EMPTY_PEG_4X2 : S_FILLED_4X2;
+        case SpriteSize_6x3: return ( peg.id == PegId_EMPTY ) ? S_EMPTY_PEG_6X3 : S_FILLED_6X3;
+        case SpriteSize_1x1:
+        default:             return oneLine;
     }
-
-	term_write( L",db." );
-	cursor_update_yx( pos.y + 1, pos.x );
-	term_write( L"`YP'" );    
 }
 
 
-void pin_write_6x3( screenpos const pos, struct Pin const pin, bool const hovered )
+static void rasterize_peg( struct Sprite *const sprite, enum SpriteSize const size, struct Peg const peg, bool const hovered )
 {
-    style_update( pin_style( pin ) );
-    cursor_update_yx( pos.y, pos.x );
+    // Nothing distinguishes a hovered peg yet, it has its own sprite so that it can.
+    (void)hovered;
 
-    if ( pin.id == PinId_INCORRECT )
-    {
-        term_write( L"      " );
-        cursor_update_yx( pos.y + 1, pos.x );
-        term_write( L"      " );
-        cursor_update_yx( pos.y + 2, pos.x );
-        term_write( L"      " );
-        return;
-    }
+    utf16 const character = peg.hidden ? L'?'
+                          : ( peg.id == PegId_EMPTY ) ? UTF16C_SmallDottedCircle
+                          : UTF16C_BigFilledCircle;
+    utf16 const *const oneLine[] = { (utf16 const[]) { character, L'\0' } };
 
-	term_write( L",d||b." );
-	cursor_update_yx( pos.y + 1, pos.x );
-	term_write( L"OOOOOO" );
-	cursor_update_yx( pos.y + 2, pos.x );
-	term_write( L"`Y||P'" );
+    rasterize_sprite( sprite, size, peg_style( peg ), peg_lines( size, peg, oneLine ) );
 }
 
 
-void peg_write_1x1( screenpos const pos, struct Peg const peg )
+static utf16 const *const *pin_lines( enum SpriteSize const size, struct Pin const pin, utf16 const *const oneLine[] )
 {
-    style_update( peg_style( peg ) );
-    cursor_update_yx( pos.y, pos.x );
-
-    if ( peg.hidden )
+    switch ( size )
     {
-        term_write( L"?" );
-        return;
+        case SpriteSize_4x2: return ( pin.id == PinId_INCORRECT ) ? S_EMPTY_PIN_4X2 : S_FILLED_4X2;
+        case SpriteSize_6x3: return ( pin.id == PinId_INCORRECT ) ? S_EMPTY_PIN_6X3 : S_FILLED_6X3;
+        case SpriteSize_1x1:
+        default:             return oneLine;
     }
-    else if ( peg.id == PegId_EMPTY )
+}
+
+
+static void rasterize_pin( struct Sprite *const sprite, enum SpriteSize const size, struct Pin const pin, bool const hovered )
+{
+    (void)hovered;
+
+    utf16 const character = ( pin.id == PinId_INCORRECT ) ? L' ' : UTF16C_SmallFilledCircle;
+    utf16 const *const oneLine[] = { (utf16 const[]) { character, L'\0' } };
+
+    rasterize_sprite( sprite, size, pin_style( pin ), pin_lines( size, pin, oneLine ) );
+}
+
+
+void piece_init( void )
+{
+    for ( enum SpriteSize size = 0; size < SpriteSize_Count; ++size )
     {
-        term_write( L"%lc", UTF16C_SmallDottedCircle );
-        return;
+        for ( usize hovered = 0; hovered < 2; ++hovered )
+        {
+            for ( enum PegId id = 0; id < PegId_Count; ++id )
+            {
+                for ( usize hidden = 0; hidden < 2; ++hidden )
+                {
+                    struct Peg const peg = (struct Peg) { .id = id, .hidden = hidden };
+                    rasterize_peg( &s_pegSprites[size][id][hidden][hovered], size, peg, hovered );
+                }
+            }
+            for ( enum PinId id = 0; id < PinId_Count; ++id )
+            {
+                rasterize_pin( &s_pinSprites[size][id][hovered], size, (struct Pin) { .id = id }, hovered );
+            }
+        }
     }
+    s_spritesInitialized = true;
+}
 
-    term_write( L"%lc", UTF16C_BigFilledCircle );
+
+static void draw_sprite( screenpos const pos, struct Sprite const *sprite )
+{
+    assert( s_spritesInitialized );
+
+    term_blit( pos, sprite->size, sprite->characters );
+
+    // Same style and cursor left behind as a formatted write of the piece, for the callers writing right after it.
+    style_update( sprite->style );
+    cursor_update_yx( pos.y + sprite->size.h - 1, pos.x + sprite->size.w );
 }
 
 
-void peg_write_4x2( screenpos const pos, struct Peg const peg )
+static void draw_peg( screenpos const pos, enum SpriteSize const size, struct Peg const peg, bool const hovered )
 {
-    style_update( peg_style( peg ) );
-    cursor_update_yx( pos.y, pos.x );
+    assert( peg.id < PegId_Count );
+    draw_sprite( pos, &s_pegSprites[size][peg.id][peg.hidden][hovered] );
+}
 
-    if ( peg.id == PegId_EMPTY )
-    {
-        term_write( L".''." );
-	    cursor_update_yx( pos.y + 1, pos.x );
-	    term_write( L"`,,'" );
-        return;
-    }
 
-	term_write( L",db." );
-	cursor_update_yx( pos.y + 1, pos.x );
-	term_write( L"`YP'" );   
+static void draw_pin( screenpos const pos, enum SpriteSize const size, struct Pin const pin, bool const hovered )
+{
+    assert( pin.id < PinId_Count );
+    draw_sprite( pos, &s_pinSprites[size][pin.id][hovered] );
 }
 
 
-void peg_write_6x3( screenpos const pos, struct Peg const peg, bool const hovered )
+struct Character const *peg_sprite_4x2( struct Peg const peg )
 {
-    style_update( peg_style( peg ) );
-    cursor_update_yx( pos.y, pos.x );
+    assert( s_spritesInitialized && peg.id < PegId_Count );
+    return s_pegSprites[SpriteSize_4x2][peg.id][peg.hidden][false].characters;
+}
+
+
+void pin_write_1x1( screenpos const pos, struct Pin const pin )
+{
+    draw_pin( pos, SpriteSize_1x1, pin, false );
+}
+
+
+void pin_write_4x2( screenpos const pos, struct Pin const pin )
+{
+    draw_pin( pos, SpriteSize_4x2, pin, false );
+}
+
+
+void pin_write_6x3( screenpos const pos, struct Pin const pin, bool const hovered )
+{
+    draw_pin( pos, SpriteSize_6x3, pin, hovered );
+}
+
+
+void peg_write_1x1( screenpos const pos, struct Peg const peg )
+{
+    draw_peg( pos, SpriteSize_1x1, peg, false );
+}
+
+
+void peg_write_4x2( screenpos const pos, struct Peg const peg )
+{
+    draw_peg( pos, SpriteSize_4x2, peg, false );
+}
 
-    if ( peg.id == PegId_EMPTY )
-    {
-        term_write( L",:'':." );
-        cursor_update_yx( pos.y + 1, pos.x );
-        term_write( L":    :" );
-        cursor_update_yx( pos.y + 2, pos.x );
-        term_write( L"`:,,:'" );
-        return;
-    }
 
-	term_write( L",d||b." );
-	cursor_update_yx( pos.y + 1, pos.x );
-	term_write( L"OOOOOO" );
-	cursor_update_yx( pos.y + 2, pos.x );
-	term_write( L"`Y||P'" );
+void peg_write_6x3( screenpos const pos, struct Peg const peg, bool const hovered )
+{
+    draw_peg( pos, SpriteSize_6x3, peg, hovered );
 }
 
 
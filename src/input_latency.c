@@ -0,0 +1,141 @@
+#include "input_latency.h"
+
+#include "terminal/terminal.h"
+
+#include <stdio.h>
+
+
+enum // Constants
+{
+    // Requests waiting for their frame to be written. Past this, the next ones aren't measured.
+    MAX_PENDING_REQUESTS = 64
+};
+
+
+struct PendingRequest
+{
+    enum RequestType type;
+    nsecond arrival;
+    usize frameIndex;
+    bool hasFrame;
+};
+
+
+static char const *const S_REQUEST_NAMES[RequestType_Count] =
+{
+    [RequestType_START_NEW_GAME]  = "START_NEW_GAME",
+    [RequestType_ABANDON_GAME]    = "ABANDON_GAME",
+    [RequestType_REVEAL_SOLUTION] = "REVEAL_SOLUTION",
+    [RequestType_HIDE_SOLUTION]   = "HIDE_SOLUTION",
+    [RequestType_PEG_SELECT]      = "PEG_SELECT",
+    [RequestType_PEG_UNSELECT]    = "PEG_UNSELECT",
+    [RequestType_PEG_ADD]         = "PEG_ADD",
+    [RequestType_PEG_REMOVE]      = "PEG_REMOVE",
+    [RequestType_CONFIRM_TURN]    = "CONFIRM_TURN",
+    [RequestType_RESET_TURN]      = "RESET_TURN",
+    [RequestType_NEXT]            = "NEXT",
+    [RequestType_PREVIOUS]        = "PREVIOUS",
+    [RequestType_EXIT_APP]        = "EXIT_APP",
+};
+
+static struct FrameHistogram s_histograms[RequestType_Count];
+static struct PendingRequest s_pending[MAX_PENDING_REQUESTS];
+static usize s_nbPending;
+static usize s_nbFramesSentSeen;
+
+
+usize input_latency_damage_mark( void )
+{
+    usize nbCells = 0;
+    for ( u8 owner = 0; owner < TERM_MAX_DAMAGE_OWNERS; ++owner )
+    {
+        nbCells += term_damage_totals( owner ).nbCells;
+    }
+    return nbCells;
+}
+
+
+void input_latency_on_request( enum RequestType const type, nsecond const arrival, usize const damageMark )
+{
+    assert( type < RequestType_Count );
+    // Nothing written while handling it: no frame to wait for.
+    if ( input_latency_damage_mark() <= damageMark ) return;
+    if ( s_nbPending >= MAX_PENDING_REQUESTS ) return;
+
+    s_pending[s_nbPending++] = (struct PendingRequest) { .type = type, .arrival = arrival };
+}
+
+
+void input_latency_on_refresh( void )
+{
+    usize const nbFramesSent = term_nb_frames_sent();
+    bool const frameSent = nbFramesSent != s_nbFramesSentSeen;
+    s_nbFramesSentSeen = nbFramesSent;
+    bool const changesLeft = term_has_pending_changes();
+
+    usize nbKept = 0;
+    for ( usize idx = 0; idx < s_nbPending; ++idx )
+    {
+        struct PendingRequest request = s_pending[idx];
+
+        if ( !request.hasFrame )
+        {
+            if ( frameSent )
+            {
+                request.frameIndex = nbFramesSent - 1;
+                request.hasFrame = true;
+            }
+            // Nothing sent, and nothing left to send: the request didn't change anything.
+            else if ( !changesLeft ) continue;
+        }
+
+        nsecond writeEnd;
+        if ( request.hasFrame && term_frame_written_time( request.frameIndex, &writeEnd ) )
+        {
+            // 0 when written too long ago to be known.
+            if ( writeEnd >= request.arrival )
+            {
+                frame_histogram_record( &s_histograms[request.type], writeEnd - request.arrival );
+            }
+            continue;
+        }
+
+        s_pending[nbKept++] = request;
+    }
+    s_nbPending = nbKept;
+}
+
+
+struct FrameHistogram const *input_latency_histogram( enum RequestType const type )
+{
+    assert( type < RequestType_Count );
+    return &s_histograms[type];
+}
+
+
+char const *input_latency_request_name( enum RequestType const type )
+{
+    assert( type < RequestType_Count );
+    return S_REQUEST_NAMES[type];
+}
+
+
+bool input_latency_dump_histograms( char const *const path )
+{
+    FILE *const file = fopen( path, "w" );
+    if ( !file )
+    {
+        fprintf( stderr, "[ERROR]: Failed to open %s to dump the input latency histograms.\n", path );
+        return false;
+    }
+
+    fprintf( file, "request,lower_ns,upper_ns,count\n" );
+    for ( usize idx = 0; idx < RequestType_Count; ++idx )
+    {
+        if ( frame_histogram_count( &s_histograms[idx] ) == 0 ) continue;
+        frame_histogram_dump( &s_histograms[idx], S_REQUEST_NAMES[idx], file );
+    }
+
+    fclose( file );
+    return true;
+}
@@ -0,0 +1,224 @@
+#include "input_reader.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+
+enum // Constants
+{
+    // Power of two, for the indices to wrap around freely.
+    INPUT_RING_CAPACITY = 1024,
+    // Inputs read from the console at once.
+    READ_BATCH_SIZE = 64
+};
+
+static_assert( ( INPUT_RING_CAPACITY & ( INPUT_RING_CAPACITY - 1 ) ) == 0 );
+
+
+struct TimedInput
+{
+    INPUT_RECORD record;
+    nsecond arrival;
+};
+
+
+struct InputReader
+{
+    HANDLE thread;
+    HANDLE inputHandle;
+    HANDLE inputsQueued[InputSignal_Count]; // Auto-reset events, all signaled once inputs are pushed.
+    HANDLE spaceFreed;   // Auto-reset event, signaled once inputs are popped while the reader waits for space.
+    HANDLE stop;         // Manual-reset event.
+
+    // Only written by the reader thread (head) and the main thread (tail). Both only ever increase.
+    struct TimedInput ring[INPUT_RING_CAPACITY];
+    atomic_size_t head;
+    atomic_size_t tail;
+    atomic_bool readerWaitsForSpace;
+};
+
+
+static struct InputReader s_reader;
+
+
+static usize free_space( void )
+{
+    usize const head = atomic_load_explicit( &s_reader.head, memory_order_relaxed );
+    usize const tail = atomic_load_explicit( &s_reader.tail, memory_order_acquire );
+    return INPUT_RING_CAPACITY - ( head - tail );
+}
+
+
+// Returns false once stopped.
+static bool wait_for_space( void )
+{
+    while ( free_space() == 0 )
+    {
+        // Set before checking again, for the main thread to see it if it pops in between.
+        atomic_store( &s_reader.readerWaitsForSpace, true );
+        // Pairs with the fence of input_reader_pop(): either the main thread sees the flag, or this sees its pop.
+        atomic_thread_fence( memory_order_seq_cst );
+        if ( free_space() == 0 )
+        {
+            HANDLE const handles[] = { s_reader.spaceFreed, s_reader.stop };
+            if ( WaitForMultipleObjects( ARR_COUNT( handles ), handles, FALSE, INFINITE ) != WAIT_OBJECT_0 )
+            {
+                return false;
+            }
+        }
+        atomic_store( &s_reader.readerWaitsForSpace, false );
+    }
+    return true;
+}
+
+
+static DWORD WINAPI reader_thread( void *param )
+{
+    INPUT_RECORD batch[READ_BATCH_SIZE];
+
+    for ( ;; )
+    {
+        if ( !wait_for_space() ) return 0;
+
+        HANDLE const handles[] = { s_reader.inputHandle, s_reader.stop };
+        if ( WaitForMultipleObjects( ARR_COUNT( handles ), handles, FALSE, INFINITE ) != WAIT_OBJECT_0 )
+        {
+            return 0;
+        }
+
+        // Never more than the ring can take: the rest stays in the console queue.
+        DWORD nbEvents = 0;
+        if ( !GetNumberOfConsoleInputEvents( s_reader.inputHandle, &nbEvents ) || nbEvents == 0 ) continue;
+        DWORD const nbToRead = (DWORD)min( min( (usize)nbEvents, free_space() ), (usize)READ_BATCH_SIZE );
+
+        DWORD nbInputsRead = 0;
+        if ( !ReadConsoleInput( s_reader.inputHandle, &batch[0], nbToRead, &nbInputsRead ) )
+        {
+            fprintf( stderr, "[ERROR]: ReadConsoleInput failure. (Code %lu)\n", GetLastError() );
+            continue;
+        }
+        nsecond const arrival = time_get_timestamp_nsec();
+
+        usize const head = atomic_load_explicit( &s_reader.head, memory_order_relaxed );
+        for ( DWORD idx = 0; idx < nbInputsRead; ++idx )
+        {
+            s_reader.ring[( head + idx ) % INPUT_RING_CAPACITY] = (struct TimedInput) {
+                .record = batch[idx],
+                .arrival = arrival
+            };
+        }
+        atomic_store_explicit( &s_reader.head, head + nbInputsRead, memory_order_release );
+        for ( usize signal = 0; signal < InputSignal_Count; ++signal )
+        {
+            SetEvent( s_reader.inputsQueued[signal] );
+        }
+    }
+}
+
+
+static void close_handles( void )
+{
+    for ( usize signal = 0; signal < InputSignal_Count; ++signal )
+    {
+        if ( s_reader.inputsQueued[signal] ) CloseHandle( s_reader.inputsQueued[signal] );
+        s_reader.inputsQueued[signal] = NULL;
+    }
+    if ( s_reader.spaceFreed ) CloseHandle( s_reader.spaceFreed );
+    if ( s_reader.stop ) CloseHandle( s_reader.stop );
+    s_reader.spaceFreed = NULL;
+    s_reader.stop = NULL;
+}
+
+
+bool input_reader_start( void *const inputHandle )
+{
+    assert( s_reader.thread == NULL );
+
+    s_reader.inputHandle = inputHandle;
+    atomic_store( &s_reader.head, 0 );
+    atomic_store( &s_reader.tail, 0 );
+    atomic_store( &s_reader.readerWaitsForSpace, false );
+
+    bool eventsCreated = true;
+    for ( usize signal = 0; signal < InputSignal_Count; ++signal )
+    {
+        s_reader.inputsQueued[signal] = CreateEventW( NULL, FALSE, FALSE, NULL );
+        eventsCreated = eventsCreated && s_reader.inputsQueued[signal] != NULL;
+    }
+    s_reader.spaceFreed = CreateEventW( NULL, FALSE, FALSE, NULL );
+    s_reader.stop = CreateEventW( NULL, TRUE, FALSE, NULL );
+    if ( !eventsCreated || s_reader.spaceFreed == NULL || s_reader.stop == NULL )
+    {
+        fprintf( stderr, "[ERROR]: CreateEvent failure for the input reader. (Code %lu)\n", GetLastError() );
+        close_handles();
+        return false;
+    }
+
+    s_reader.thread = CreateThread( NULL, 0, reader_thread, NULL, 0, NULL );
+    if ( s_reader.thread == NULL )
+    {
+        fprintf( stderr, "[ERROR]: CreateThread failure for the input reader. (Code %lu)\n", GetLastError() );
+        close_handles();
+        return false;
+    }
+
+    return true;
+}
+
+
+void input_reader_stop( void )
+{
+    if ( s_reader.thread == NULL ) return;
+
+    SetEvent( s_reader.stop );
+    WaitForSingleObject( s_reader.thread, INFINITE );
+
+    CloseHandle( s_reader.thread );
+    s_reader.thread = NULL;
+    close_handles();
+}
+
+
+void *input_reader_signal_handle( enum InputSignal const signal )
+{
+    assert( signal < InputSignal_Count );
+    return s_reader.inputsQueued[signal];
+}
+
+
+usize input_reader_nb_pending( void )
+{
+    usize const head = atomic_load_explicit( &s_reader.head, memory_order_acquire );
+    usize const tail = atomic_load_explicit( &s_reader.tail, memory_order_relaxed );
+    return head - tail;
+}
+
+
+struct _INPUT_RECORD const *input_reader_peek( usize const index, nsecond *const outArrival )
+{
+    assert( index < input_reader_nb_pending() );
+
+    usize const tail = atomic_load_explicit( &s_reader.tail, memory_order_relaxed );
+    struct TimedInput const *const input = &s_reader.ring[( tail + index ) % INPUT_RING_CAPACITY];
+    if ( outArrival ) *outArrival = input->arrival;
+    return &input->record;
+}
+
+
+void input_reader_pop( void )
+{
+    assert( input_reader_nb_pending() > 0 );
+
+    usize const tail = atomic_load_explicit( &s_reader.tail, memory_order_relaxed );
+    atomic_store_explicit( &s_reader.tail, tail + 1, memory_order_release );
+
+    // Pairs with the fence of wait_for_space(): either this sees the flag, or the reader sees the new tail.
+    atomic_thread_fence( memory_order_seq_cst );
+    if ( atomic_load_explicit( &s_reader.readerWaitsForSpace, memory_order_relaxed ) )
+    {
+        SetEvent( s_reader.spaceFreed );
+    }
+}
@@ -29,6 +29,8 @@ enum KeyInput keybinding_get_binded_key( enum KeyBinding keybinding )
         case KeyBinding_PREVIOUS:           return KeyInput_ARROW_LEFT;
         case KeyBinding_NEXT:               return KeyInput_ARROW_RIGHT;
 
+        case KeyBinding_LATENCY_OVERLAY:    return KeyInput_L;
+
         default:                            return KeyInput_INVALID;
     }
 }
@@ -11,6 +11,10 @@
 #include "ui/ui.h"
 #include "events.h"
 #include "requests.h"
+#include "game/piece.h"
+#include "trace.h"
+#include "input_reader.h"
+#include "input_latency.h"
 
 #include "terminal/terminal.h"
 
@@ -30,6 +34,13 @@ enum ExitCode
 	ExitCode_FAILURE
 };
 
+enum // Constants
+{
+	// Past these, the remaining inputs are consumed on the next frames, so that a burst doesn't delay the frame.
+	MAX_INPUTS_PER_FRAME = 32,
+	INPUTS_TIME_BUDGET_NSEC = 2 * Time_MSEC_IN_NSEC
+};
+
 static bool s_mainLoop = true;
 
 
@@ -45,7 +56,7 @@ enum RequestStatus gameloop_on_request( struct Request const *req )
 }
 
 
-static void consume_recorded_input( INPUT_RECORD const *const recordedInput )
+static void consume_recorded_input( INPUT_RECORD const *const recordedInput, nsecond const arrival )
 {
 	assert( recordedInput );
 
@@ -59,7 +70,7 @@ static void consume_recorded_input( INPUT_RECORD const *const recordedInput )
 		}
 		case MOUSE_EVENT:
 		{
-			mouse_consume_event( &recordedInput->Event.MouseEvent );
+			mouse_consume_event( &recordedInput->Event.MouseEvent, arrival );
 			return;
 		}
 		case KEY_EVENT:
@@ -74,7 +85,7 @@ static void consume_recorded_input( INPUT_RECORD const *const recordedInput )
 				{
 					input = key_input_from_numpad_to_number( input );
 				}
-				struct Event const event = EVENT_INPUT( input );
+				struct Event const event = EVENT_INPUT( input, arrival );
 				event_trigger( &event );
 			}
 			break;
@@ -89,31 +100,71 @@ static void consume_recorded_input( INPUT_RECORD const *const recordedInput )
 }
 
 
-static bool consume_user_inputs( void )
+// Only the last of consecutive moves or resizes matters: the others would be drawn over in the same frame.
+// Moves with a button held are all kept, each of them being a click for the widgets.
+static bool is_superseded_by( INPUT_RECORD const *const input, INPUT_RECORD const *const next )
+{
+	if ( input->EventType != next->EventType ) return false;
+
+	if ( input->EventType == WINDOW_BUFFER_SIZE_EVENT ) return true;
+	if ( input->EventType != MOUSE_EVENT ) return false;
+
+	MOUSE_EVENT_RECORD const *const mouse = &input->Event.MouseEvent;
+	MOUSE_EVENT_RECORD const *const nextMouse = &next->Event.MouseEvent;
+	return mouse->dwEventFlags == MOUSE_MOVED && mouse->dwButtonState == 0
+		&& nextMouse->dwEventFlags == MOUSE_MOVED && nextMouse->dwButtonState == 0;
+}
+
+
+// The inputs are read by the input reader thread, they are only dispatched here.
+static void consume_user_inputs( void )
 {
-	DWORD nbEvents = 0;
-	if ( !GetNumberOfConsoleInputEvents( term_input_handle(), &nbEvents ) )
+	usize nbPending = input_reader_nb_pending();
+	if ( nbPending == 0 ) return; // Nothing to do.
+
+	nsecond const begin = time_get_timestamp_nsec();
+	usize nbConsumed = 0;
+
+	while ( nbPending > 0 && nbConsumed < MAX_INPUTS_PER_FRAME )
 	{
-		fprintf( stderr, "[ERROR]: GetNumberOfConsoleInputEvents failure. (Code %lu)\n", GetLastError() );
-		return false;
+		nsecond arrival;
+		INPUT_RECORD const *const input = input_reader_peek( 0, &arrival );
+		bool const superseded = nbPending > 1 && is_superseded_by( input, input_reader_peek( 1, NULL ) );
+
+		if ( !superseded )
+		{
+			consume_recorded_input( input, arrival );
+			nbConsumed += 1;
+		}
+		input_reader_pop();
+		nbPending -= 1;
+
+		// At least one input per frame, however long it takes.
+		if ( !superseded && time_get_timestamp_nsec() - begin >= INPUTS_TIME_BUDGET_NSEC ) break;
 	}
-	if ( nbEvents == 0 ) return true; // Nothing to do.
+	fpscounter_on_activity( fpscounter_get_instance() );
+}
+
 
-	// TODO: Perhaps have a limit of the number of inputs to acknowledge by frame
-	// And discard the rest to not take too much delay between the pressed input and the game update.
-	// Example: If the user spam keys, we will discard some of them to stay on track
+// Blocks until there is something to do: an input to consume, or a widget changing by itself.
+// The screen must have nothing left to refresh.
+static bool wait_for_activity( void )
+{
+	DWORD timeoutMs = INFINITE;
 
-	DWORD nbInputsRead;
-	INPUT_RECORD inputsBuffer[nbEvents];
-	if ( !ReadConsoleInput( term_input_handle(), &inputsBuffer[0], nbEvents, &nbInputsRead ) )
+	nsecond const nextUpdate = ui_next_update_time();
+	if ( nextUpdate != 0 )
 	{
-		fprintf( stderr, "[ERROR]: ReadConsoleInput failure. (Code %lu)\n", GetLastError() );
-		return false;
+		nsecond const now = time_get_timestamp_nsec();
+		// Rounded up, to wake up once the widget has changed and not right before.
+		timeoutMs = ( nextUpdate > now ) ? (DWORD)( ( nextUpdate - now + Time_MSEC_IN_NSEC - 1 ) / Time_MSEC_IN_NSEC ) : 0;
 	}
 
-	for ( DWORD idx = 0; idx < nbInputsRead; ++idx )
+	HANDLE const handles[] = { input_reader_signal_handle( InputSignal_ACTIVITY ) };
+	if ( WaitForMultipleObjects( ARR_COUNT( handles ), handles, FALSE, timeoutMs ) == WAIT_FAILED )
 	{
-		consume_recorded_input( &inputsBuffer[idx] );
+		fprintf( stderr, "[ERROR]: WaitForMultipleObjects failure. (Code %lu)\n", GetLastError() );
+		return false;
 	}
 
 	return true;
@@ -126,10 +177,15 @@ bool init_systems( void )
 
 	success = success && random_init();
 	success = success && term_init( "Mastermind", true );
+	piece_init();
 	success = success && ( fpscounter_init() != NULL );
 	success = success && settings_init();
 	success = success && mouse_init();
 	success = success && ui_init();
+	success = success && input_reader_start( term_input_handle() );
+
+	// Idle frames end as soon as there is an input.
+	fpscounter_wake_on( fpscounter_get_instance(), input_reader_signal_handle( InputSignal_IDLE_FRAME ) );
 
 	return success;
 }
@@ -137,7 +193,27 @@ bool init_systems( void )
 
 void uninit_systems( void )
 {
+	// Set to a file path to compare the frame times of two builds offline.
+	char const *const histogramsPath = getenv( "MASTERMIND_FRAME_HISTOGRAMS" );
+	if ( histogramsPath )
+	{
+		fpscounter_dump_histograms( fpscounter_get_instance(), histogramsPath );
+	}
+	char const *const latencyPath = getenv( "MASTERMIND_INPUT_LATENCY" );
+	if ( latencyPath )
+	{
+		input_latency_dump_histograms( latencyPath );
+	}
+	// Only with a build recording traces, see trace.h.
+	char const *const tracePath = getenv( "MASTERMIND_TRACE" );
+	if ( tracePath )
+	{
+		TRACE_FLUSH( tracePath );
+	}
+
+	input_reader_stop();
 	ui_uninit();
+	event_uninit();
 	fpscounter_uninit( fpscounter_get_instance() );
 	term_uninit();
 }
@@ -154,11 +230,30 @@ int main( void )
 
 	while ( s_mainLoop )
 	{
+		TRACE_BEGIN( "consume_user_inputs" );
 		consume_user_inputs();
+		TRACE_END();
+		fpscounter_phase_end( fpscounter_get_instance(), FramePhase_INPUT );
+		TRACE_BEGIN( "ui_frame" );
 		ui_frame();
+		TRACE_END();
+		fpscounter_phase_end( fpscounter_get_instance(), FramePhase_UI );
+		// Something is animating, the idle framerate would show.
+		if ( term_has_pending_changes() ) fpscounter_on_activity( fpscounter_get_instance() );
+		TRACE_BEGIN( "term_refresh" );
 		term_refresh();
-		// Last function call in the loop
+		TRACE_END();
+		input_latency_on_refresh();
+		fpscounter_phase_end( fpscounter_get_instance(), FramePhase_REFRESH );
+		// Fewer frames give the terminal time to catch up, and merge more changes in each of them.
+		fpscounter_set_throttled( fpscounter_get_instance(), term_is_link_saturated() );
 		fpscounter_frame( fpscounter_get_instance() );
+
+		// Nothing changes on the screen until the next input or widget update: no need to run the frames meanwhile.
+		if ( s_mainLoop && input_reader_nb_pending() == 0 && !term_has_pending_changes() && wait_for_activity() )
+		{
+			fpscounter_resume( fpscounter_get_instance() );
+		}
 	}
 
 	uninit_systems();
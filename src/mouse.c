@@ -15,7 +15,7 @@ screenpos mouse_pos( void )
 }
 
 
-static void mouse_moved( vec2u16 const mousePos )
+static void mouse_moved( vec2u16 const mousePos, nsecond const arrival )
 {
     screenpos const oldPos = mouse_pos();
 	screenpos const newPos = (screenpos) { .x = mousePos.x + 1, .y = mousePos.y + 1 };
@@ -28,19 +28,20 @@ static void mouse_moved( vec2u16 const mousePos )
     struct Event mouseMoved = (struct Event) {
         .type = EventType_MOUSE_MOVED,
         .mouseMoved = (struct EventMouseMoved) {
-            .pos = s_currPosition
+            .pos = s_currPosition,
+            .arrival = arrival
         }
     };
     event_trigger( &mouseMoved );
 }
 
 
-void mouse_consume_event( struct _MOUSE_EVENT_RECORD const *mouseEvent )
+void mouse_consume_event( struct _MOUSE_EVENT_RECORD const *mouseEvent, nsecond const arrival )
 {
 	// If the mouse moved but didn't move enough to change its coordinates on the screen,
 	// the event won't be sent. However, the MOUSE_MOVED won't necessarily be sent with it, so do not encapsulate
 	// the move condition in it.
-	mouse_moved( *(vec2u16 *)&mouseEvent->dwMousePosition );
+	mouse_moved( *(vec2u16 *)&mouseEvent->dwMousePosition, arrival );
 
     if ( mouseEvent->dwEventFlags == MOUSE_WHEELED )
     {
@@ -52,19 +53,19 @@ void mouse_consume_event( struct _MOUSE_EVENT_RECORD const *mouseEvent )
         // If the high word of the dwButtonState member contains a positive value, the wheel was rotated forward, away from the user.
         // Otherwise, the wheel was rotated backward, toward the user.
         enum KeyInput const input = ( (short)HIWORD( mouseEvent->dwButtonState ) > 0 ) ? KeyInput_ARROW_UP : KeyInput_ARROW_DOWN;
- 	    struct Event const event = EVENT_INPUT( input );
+ 	    struct Event const event = EVENT_INPUT( input, arrival );
 		event_trigger( &event );
         return;
     }
 
 	if ( mouseEvent->dwButtonState == FROM_LEFT_1ST_BUTTON_PRESSED )
 	{
-   	    struct Event const event = EVENT_INPUT( KeyInput_MOUSE_BTN_LEFT );
+   	    struct Event const event = EVENT_INPUT( KeyInput_MOUSE_BTN_LEFT, arrival );
 		event_trigger( &event );
 	}
 	else if ( mouseEvent->dwButtonState == RIGHTMOST_BUTTON_PRESSED )
 	{
-   	    struct Event const event = EVENT_INPUT( KeyInput_MOUSE_BTN_RIGHT );
+   	    struct Event const event = EVENT_INPUT( KeyInput_MOUSE_BTN_RIGHT, arrival );
 		event_trigger( &event );
 	}
 }
@@ -98,6 +98,13 @@ static usize draw_optional_border_title( utf16 const *const optTitle, usize cons
 }
 
 
+// Blanks are written with the current style, as a formatted write of spaces would.
+static inline struct Character blank_character( void )
+{
+	return character_make( L' ', style_current() );
+}
+
+
 void rect_draw_borders( struct Rect const *rect, utf16 const *optTitle )
 {
 	if ( rect->size.w < 3 || rect->size.h < 3 ) return;
@@ -105,73 +112,58 @@ void rect_draw_borders( struct Rect const *rect, utf16 const *optTitle )
     style_update( STYLE( FGColor_BRIGHT_BLACK ) );
 	
 	screenpos const ul = rect_get_ul_corner( rect );
+	screenpos const br = rect_get_br_corner( rect );
 	usize const widthNoCorners = rect->size.w - 2;
+	vec2u16 const verticalSize = VEC2U16( 1, rect->size.h - 2 );
+	struct Style const style = style_current();
 
 	// First line
-    cursor_update_pos( ul );
-    term_write( L"┌" );
+    term_put_run( ul, style, L"┌", 1 );
 	usize const titleSize = draw_optional_border_title( optTitle, widthNoCorners );
 
-    for ( usize x = 0; x < ( widthNoCorners - titleSize ); ++x )
-	{
-		term_write( L"─" );
-	}
-    term_write( L"┐" );
+	screenpos const afterTitle = SCREENPOS( ul.x + 1 + titleSize, ul.y );
+	term_fill( afterTitle, VEC2U16( widthNoCorners - titleSize, 1 ), character_make( L'─', style ) );
+    term_put_run( SCREENPOS( br.x, ul.y ), style, L"┐", 1 );
 
 	// Vertical middle lines
-    for ( usize y = 1; y < rect->size.h - 1u; ++y )
-    {
-        cursor_update_yx( ul.y + y, ul.x );
-        term_write( L"│" );
-        cursor_move_right_by( widthNoCorners );
-        term_write( L"│" );
-    }
+	term_fill( SCREENPOS( ul.x, ul.y + 1 ), verticalSize, character_make( L'│', style ) );
+	term_fill( SCREENPOS( br.x, ul.y + 1 ), verticalSize, character_make( L'│', style ) );
 
 	// Last line
-    cursor_update_yx( ul.y + rect->size.h - 1, ul.x );
-    term_write( L"└" );
-    for ( usize x = 0; x < widthNoCorners; ++x ) term_write( L"─" );
-    term_write( L"┘" );
+    term_put_run( SCREENPOS( ul.x, br.y ), style, L"└", 1 );
+	term_fill( SCREENPOS( ul.x + 1, br.y ), VEC2U16( widthNoCorners, 1 ), character_make( L'─', style ) );
+    term_put_run( br, style, L"┘", 1 );
 }
 
 
 void rect_clear( struct Rect const *rect )
 {
-	screenpos const ul = rect_get_ul_corner( rect );
-    for ( usize y = 0; y < rect->size.h; ++y )
-    {
-        cursor_update_yx( ul.y + y, ul.x );
-		term_write( L"%*lc", rect->size.w, L' ' );
-    }
+	term_fill( rect_get_ul_corner( rect ), rect->size, blank_character() );
 }
 
 
 void rect_clear_content( struct Rect const *rect )
 {
+	if ( rect->size.w < 3 || rect->size.h < 3 ) return;
+
 	screenpos const ul = rect_get_ul_corner( rect );
-    for ( usize y = 1; y < rect->size.h - 1u; ++y )
-    {
-        cursor_update_yx( ul.y + y, ul.x + 1u );
-		term_write( L"%*lc", rect->size.w - 2u, L' ' );
-    }
+	term_fill( SCREENPOS( ul.x + 1, ul.y + 1 ), VEC2U16( rect->size.w - 2, rect->size.h - 2 ), blank_character() );
 }
 
 
 void rect_clear_borders( struct Rect const *rect )
 {
 	screenpos const ul = rect_get_ul_corner( rect );
+	struct Character const blank = blank_character();
 
-	cursor_update_yx( ul.y, ul.x );
-	term_write( L"%*lc", rect->size.w, L' ' );
+	term_fill( ul, VEC2U16( rect->size.w, 1 ), blank );
 
-    for ( usize y = 1; y < rect->size.h - 1u; ++y )
-    {
-        cursor_update_yx( ul.y + y, ul.x );
-		term_write( L" " );
-		cursor_move_right_by( rect->size.w - 2u );
-		term_write( L" " );
-    }	
+	if ( rect->size.h > 2 )
+	{
+		vec2u16 const verticalSize = VEC2U16( 1, rect->size.h - 2 );
+		term_fill( SCREENPOS( ul.x, ul.y + 1 ), verticalSize, blank );
+		term_fill( SCREENPOS( ul.x + rect->size.w - 1, ul.y + 1 ), verticalSize, blank );
+	}
 
-	cursor_update_yx( ul.y + rect->size.h, ul.x );
-	term_write( L"%*lc", rect->size.w, L' ' );
+	term_fill( SCREENPOS( ul.x, ul.y + rect->size.h ), VEC2U16( rect->size.w, 1 ), blank );
 }
@@ -1,10 +1,24 @@
 #include "requests.h"
 #include "mastermind.h"
 #include "gameloop.h"
+#include "events.h"
+#include "input_latency.h"
 
-void request_send( struct Request const *request )
+static void dispatch_request( struct Request const *request )
 {
     // KISS for the moment.
     if ( mastermind_on_request( request ) == RequestStatus_TREATED ) return;
     if ( gameloop_on_request( request ) == RequestStatus_TREATED ) return;
 }
+
+
+void request_send( struct Request const *request )
+{
+    // Measured until the frame showing its consequences is written, when it comes from an input.
+    nsecond const inputArrival = event_input_arrival();
+    usize const damageMark = ( inputArrival != 0 ) ? input_latency_damage_mark() : 0;
+
+    dispatch_request( request );
+
+    if ( inputArrival != 0 ) input_latency_on_request( request->type, inputArrival, damageMark );
+}
@@ -1,5 +1,7 @@
 #include "settings.h"
 
+#include "fps_counter.h"
+
 struct Settings
 {
     // General Settings
@@ -18,11 +20,11 @@ struct Settings s_settings = {};
 
 bool settings_init( void )
 {
-    s_settings.cappedFramerate = 90; // -> Instead of having a getter, it will directly set it by calling the FPSCounter.
-
     // Changing it times to times in order to spot potential bugs in the display.
     bool result = true;
 
+    result &= settings_set_capped_framerate( 90 );
+
     result &= settings_set_nb_turns( Mastermind_MAX_TURNS );
     result &= settings_set_nb_pieces_per_turn( 6 );
     result &= settings_set_game_experience( GameExperience_NORMAL );
@@ -34,6 +36,18 @@ bool settings_init( void )
 }
 
 
+bool settings_set_capped_framerate( usize const framerate )
+{
+    if ( framerate < Settings_MIN_CAPPED_FRAMERATE || framerate > Settings_MAX_CAPPED_FRAMERATE )
+    {
+        return false;
+    }
+
+    s_settings.cappedFramerate = framerate;
+    fpscounter_set_capped_framerate( fpscounter_get_instance(), framerate );
+    return true;
+}
+
 bool settings_set_nb_turns( usize const nbTurns )
 {
     if ( nbTurns < Mastermind_MIN_TURNS || nbTurns > Mastermind_MAX_TURNS )
@@ -77,6 +91,11 @@ bool settings_set_duplicate_allowed( bool allowed )
 
 // 
 
+usize settings_get_capped_framerate( void )
+{
+    return s_settings.cappedFramerate;
+}
+
 usize settings_get_nb_turns( void )
 {
     return s_settings.gameNbTurns;
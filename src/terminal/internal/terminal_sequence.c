@@ -4,9 +4,159 @@
 
 #include <stdio.h>
 
+
+enum // Constants
+{
+    SGR_CODE_MAX_SIZE = 4,
+
+    // Worst case: reset + 6 attributes + foreground + background.
+    SGR_MAX_PARAMETERS = 9,
+
+    ATTR_BITS_COUNT = 6,
+    COLOR_NIBBLE_COUNT = 16
+};
+
+
+// A single SGR parameter (the part between the ';'), precomputed so that no formatting
+// is needed at runtime when building the frame.
+struct SGRCode
+{
+    u8 size;
+    ascii code[SGR_CODE_MAX_SIZE];
+};
+
+#define SGR_CODE( _code ) { .size = sizeof( _code ) - 1, .code = _code }
+
+static struct SGRCode const S_SGR_RESET = SGR_CODE( "0" );
+
+// Indexed by the bit position of the attribute in enum Attr.
+static struct SGRCode const S_SGR_ATTR_ON[ATTR_BITS_COUNT] =
+{
+    SGR_CODE( "1" ), // Bold
+    SGR_CODE( "2" ), // Faint
+    SGR_CODE( "3" ), // Italic
+    SGR_CODE( "4" ), // Underline
+    SGR_CODE( "5" ), // Blink
+    SGR_CODE( "9" ), // Strikethrough
+};
+
+// Note: 22 turns off both bold and faint, there is no dedicated code for each of them.
+static struct SGRCode const S_SGR_ATTR_OFF[ATTR_BITS_COUNT] =
+{
+    SGR_CODE( "22" ), // Bold
+    SGR_CODE( "22" ), // Faint
+    SGR_CODE( "23" ), // Italic
+    SGR_CODE( "24" ), // Underline
+    SGR_CODE( "25" ), // Blink
+    SGR_CODE( "29" ), // Strikethrough
+};
+
+// Indexed by the foreground / background nibble of a termcolor (3 bits of color + 1 bit of brightness).
+static struct SGRCode const S_SGR_FOREGROUND[COLOR_NIBBLE_COUNT] =
+{
+    SGR_CODE( "30" ), SGR_CODE( "31" ), SGR_CODE( "32" ), SGR_CODE( "33" ),
+    SGR_CODE( "34" ), SGR_CODE( "35" ), SGR_CODE( "36" ), SGR_CODE( "37" ),
+    SGR_CODE( "90" ), SGR_CODE( "91" ), SGR_CODE( "92" ), SGR_CODE( "93" ),
+    SGR_CODE( "94" ), SGR_CODE( "95" ), SGR_CODE( "96" ), SGR_CODE( "97" ),
+};
+
+static struct SGRCode const S_SGR_BACKGROUND[COLOR_NIBBLE_COUNT] =
+{
+    SGR_CODE( "40" ),  SGR_CODE( "41" ),  SGR_CODE( "42" ),  SGR_CODE( "43" ),
+    SGR_CODE( "44" ),  SGR_CODE( "45" ),  SGR_CODE( "46" ),  SGR_CODE( "47" ),
+    SGR_CODE( "100" ), SGR_CODE( "101" ), SGR_CODE( "102" ), SGR_CODE( "103" ),
+    SGR_CODE( "104" ), SGR_CODE( "105" ), SGR_CODE( "106" ), SGR_CODE( "107" ),
+};
+
+#undef SGR_CODE
+
+
+struct SGRParameters
+{
+    struct SGRCode const *codes[SGR_MAX_PARAMETERS];
+    usize count;
+};
+
+
+static inline u8 foreground_nibble( termcolor const color )
+{
+    return ( color >> 4 ) & 0x0F;
+}
+
+static inline u8 background_nibble( termcolor const color )
+{
+    return color & 0x0F;
+}
+
+
+static void push_parameter( struct SGRParameters *const params, struct SGRCode const *code )
+{
+    assert( params->count < SGR_MAX_PARAMETERS );
+    params->codes[params->count++] = code;
+}
+
+
+static void push_attributes_on( struct SGRParameters *const params, termattr const attr )
+{
+    for ( usize bit = 0; bit < ATTR_BITS_COUNT; ++bit )
+    {
+        if ( ( attr & ( 1u << bit ) ) != 0 ) push_parameter( params, &S_SGR_ATTR_ON[bit] );
+    }
+}
+
+
+static void push_attributes_off( struct SGRParameters *const params, termattr const attr )
+{
+    // Bold and faint share the same code, only send it once.
+    if ( ( attr & ( Attr_BOLD | Attr_FAINT ) ) != 0 ) push_parameter( params, &S_SGR_ATTR_OFF[0] );
+
+    for ( usize bit = 2; bit < ATTR_BITS_COUNT; ++bit )
+    {
+        if ( ( attr & ( 1u << bit ) ) != 0 ) push_parameter( params, &S_SGR_ATTR_OFF[bit] );
+    }
+}
+
+
+static int write_ascii( utf16 *const outBuffer, usize const bufferSize, ascii const *str, usize const size )
+{
+    assert( size <= bufferSize );
+
+    for ( usize idx = 0; idx < size; ++idx )
+    {
+        outBuffer[idx] = (utf16)str[idx];
+    }
+    return (int)size;
+}
+
+
+// Merges all the parameters into a single CSI sequence. Nothing is written if there is no parameter.
+static int write_parameters( utf16 *const outBuffer, usize const bufferSize, struct SGRParameters const *params )
+{
+    if ( params->count == 0 ) return 0;
+
+    int nbWritten = write_ascii( outBuffer, bufferSize, "\x1b[", 2 );
+
+    for ( usize idx = 0; idx < params->count; ++idx )
+    {
+        if ( idx > 0 )
+        {
+            nbWritten += write_ascii( outBuffer + nbWritten, bufferSize - nbWritten, ";", 1 );
+        }
+        struct SGRCode const *code = params->codes[idx];
+        nbWritten += write_ascii( outBuffer + nbWritten, bufferSize - nbWritten, code->code, code->size );
+    }
+
+    nbWritten += write_ascii( outBuffer + nbWritten, bufferSize - nbWritten, "m", 1 );
+    return nbWritten;
+}
+
+
 int term_sequence_reset_style( utf16 *const outBuffer, usize const bufferSize )
 {
-    return snwprintf( outBuffer, bufferSize, L"\x1B[0;0m" );
+    struct SGRParameters params = {};
+    push_parameter( &params, &S_SGR_RESET );
+
+    return write_parameters( outBuffer, bufferSize, &params );
 }
 
 
@@ -19,35 +169,64 @@ int term_sequence_reset_cursor_pos( utf16 *const outBuffer, usize const bufferSi
 int term_sequence_set_properties( utf16 *const outBuffer, usize const bufferSize, byte const properties )
 {
     // Start with a 0 to reset the old attributes first.
-    int nbWritten = swprintf( outBuffer, bufferSize, L"\x1b[0" );
-
-    if ( attr_is_bold( properties ) )  { nbWritten += swprintf( outBuffer + nbWritten, bufferSize - nbWritten, L";1" ); }
-    if ( attr_is_faint( properties ) ) { nbWritten += swprintf( outBuffer + nbWritten, bufferSize - nbWritten, L";2" ); }
-    if ( attr_is_italic( properties ) ) { nbWritten += swprintf( outBuffer + nbWritten, bufferSize - nbWritten, L";3" ); }
-    // TODO : Complete the different edge cases [...]
-    // https://askubuntu.com/questions/528928/how-to-do-underline-bold-italic-strikethrough-color-background-and-size-i
-
-    nbWritten += swprintf( outBuffer + nbWritten, bufferSize - nbWritten, L"m" );
+    struct SGRParameters params = {};
+    push_parameter( &params, &S_SGR_RESET );
+    push_attributes_on( &params, properties & Attr_ALL );
 
-    return nbWritten;
+    return write_parameters( outBuffer, bufferSize, &params );
 }
 
 
 int term_sequence_set_color( utf16 *const outBuffer, usize const bufferSize, termcolor const color )
 {
-    u8 const fgColorCode = color_foreground_termcode( color );
-    u8 const bgColorCode = color_background_termcode( color );
+    struct SGRParameters params = {};
+    push_parameter( &params, &S_SGR_FOREGROUND[foreground_nibble( color )] );
+    push_parameter( &params, &S_SGR_BACKGROUND[background_nibble( color )] );
 
-    return snwprintf( outBuffer, bufferSize, L"\x1B[%u;%um", fgColorCode, bgColorCode );
+    return write_parameters( outBuffer, bufferSize, &params );
 }
 
 
 int term_sequence_set_style( utf16 *const outBuffer, usize const bufferSize, struct Style const style )
 {
-    int nbWritten = term_sequence_set_properties( outBuffer, bufferSize, style.attr );
-    nbWritten += term_sequence_set_color( outBuffer + nbWritten, bufferSize - nbWritten, style.color );
+    struct SGRParameters params = {};
+    push_parameter( &params, &S_SGR_RESET );
+    push_attributes_on( &params, style.attr & Attr_ALL );
+    push_parameter( &params, &S_SGR_FOREGROUND[foreground_nibble( style.color )] );
+    push_parameter( &params, &S_SGR_BACKGROUND[background_nibble( style.color )] );
 
-    return nbWritten;
+    return write_parameters( outBuffer, bufferSize, &params );
+}
+
+
+int term_sequence_set_style_delta( utf16 *const outBuffer, usize const bufferSize, struct Style const from, struct Style const to )
+{
+    termattr const fromAttr = from.attr & Attr_ALL;
+    termattr const toAttr = to.attr & Attr_ALL;
+
+    termattr const turnedOff = fromAttr & ~toAttr;
+    termattr turnedOn = toAttr & ~fromAttr;
+
+    // Turning off bold or faint clears both of them, so the one still expected needs to be set again.
+    if ( ( turnedOff & ( Attr_BOLD | Attr_FAINT ) ) != 0 )
+    {
+        turnedOn |= toAttr & ( Attr_BOLD | Attr_FAINT );
+    }
+
+    struct SGRParameters params = {};
+    push_attributes_off( &params, turnedOff );
+    push_attributes_on( &params, turnedOn );
+
+    if ( foreground_nibble( from.color ) != foreground_nibble( to.color ) )
+    {
+        push_parameter( &params, &S_SGR_FOREGROUND[foreground_nibble( to.color )] );
+    }
+    if ( background_nibble( from.color ) != background_nibble( to.color ) )
+    {
+        push_parameter( &params, &S_SGR_BACKGROUND[background_nibble( to.color )] );
+    }
+
+    return write_parameters( outBuffer, bufferSize, &params );
 }
 
 
@@ -55,3 +234,42 @@ int term_sequence_set_cursor_pos( utf16 *const outBuffer, usize const bufferSize
 {
     return snwprintf( outBuffer, bufferSize, L"\x1B[%u;%uH", pos.y, pos.x );
 }
+
+
+int term_sequence_set_scroll_region( utf16 *const outBuffer, usize const bufferSize, u16 const top, u16 const bottom )
+{
+    return snwprintf( outBuffer, bufferSize, L"\x1B[%u;%ur", top, bottom );
+}
+
+
+int term_sequence_reset_scroll_region( utf16 *const outBuffer, usize const bufferSize )
+{
+    static ascii const sequence[] = "\x1b[r";
+    return write_ascii( outBuffer, bufferSize, sequence, sizeof( sequence ) - 1 );
+}
+
+
+int term_sequence_scroll_up( utf16 *const outBuffer, usize const bufferSize, u16 const nbLines )
+{
+    return snwprintf( outBuffer, bufferSize, L"\x1B[%uS", nbLines );
+}
+
+
+int term_sequence_scroll_down( utf16 *const outBuffer, usize const bufferSize, u16 const nbLines )
+{
+    return snwprintf( outBuffer, bufferSize, L"\x1B[%uT", nbLines );
+}
+
+
+int term_sequence_begin_synchronized_update( utf16 *const outBuffer, usize const bufferSize )
+{
+    static ascii const sequence[] = "\x1b[?2026h";
+    return write_ascii( outBuffer, bufferSize, sequence, sizeof( sequence ) - 1 );
+}
+
+
+int term_sequence_end_synchronized_update( utf16 *const outBuffer, usize const bufferSize )
+{
+    static ascii const sequence[] = "\x1b[?2026l";
+    return write_ascii( outBuffer, bufferSize, sequence, sizeof( sequence ) - 1 );
+}
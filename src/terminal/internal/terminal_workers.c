@@ -0,0 +1,138 @@
+#include "terminal/internal/terminal_workers.h"
+
+#include "terminal/terminal_screen.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+
+struct Worker
+{
+    HANDLE thread;
+    HANDLE start; // Auto-reset event, signaled when a job is ready and when stopping.
+    HANDLE done;  // Auto-reset event, signaled once the job is finished.
+};
+
+
+struct WorkerPool
+{
+    struct Worker workers[TERM_MAX_ENCODERS - 1];
+    usize nbWorkers;
+
+    // Set before the workers are signaled, and left untouched until they are all done.
+    TermJobCb job;
+    void *context;
+    atomic_bool stopRequested;
+};
+
+
+static struct WorkerPool s_pool;
+
+
+static DWORD WINAPI worker_thread( void *param )
+{
+    usize const workerIdx = (usize)param;
+    struct Worker *const worker = &s_pool.workers[workerIdx];
+
+    for ( ;; )
+    {
+        WaitForSingleObject( worker->start, INFINITE );
+        if ( atomic_load( &s_pool.stopRequested ) ) return 0;
+
+        s_pool.job( s_pool.context, workerIdx + 1 );
+        SetEvent( worker->done );
+    }
+}
+
+
+static void close_worker( struct Worker *const worker )
+{
+    if ( worker->start ) CloseHandle( worker->start );
+    if ( worker->done ) CloseHandle( worker->done );
+    *worker = (struct Worker) {};
+}
+
+
+bool term_workers_start( usize const nbWorkers )
+{
+    assert( s_pool.nbWorkers == 0 );
+    assert( nbWorkers < TERM_MAX_ENCODERS );
+
+    atomic_store( &s_pool.stopRequested, false );
+
+    for ( usize idx = 0; idx < nbWorkers; ++idx )
+    {
+        struct Worker *const worker = &s_pool.workers[idx];
+        worker->start = CreateEventW( NULL, FALSE, FALSE, NULL );
+        worker->done = CreateEventW( NULL, FALSE, FALSE, NULL );
+        if ( worker->start == NULL || worker->done == NULL )
+        {
+            fprintf( stderr, "[ERROR]: CreateEvent failure for a terminal worker. (Code %lu)\n", GetLastError() );
+            close_worker( worker );
+            term_workers_stop();
+            return false;
+        }
+
+        worker->thread = CreateThread( NULL, 0, worker_thread, (void *)idx, 0, NULL );
+        if ( worker->thread == NULL )
+        {
+            fprintf( stderr, "[ERROR]: CreateThread failure for a terminal worker. (Code %lu)\n", GetLastError() );
+            close_worker( worker );
+            term_workers_stop();
+            return false;
+        }
+
+        s_pool.nbWorkers += 1;
+    }
+
+    return true;
+}
+
+
+void term_workers_stop( void )
+{
+    atomic_store( &s_pool.stopRequested, true );
+
+    for ( usize idx = 0; idx < s_pool.nbWorkers; ++idx )
+    {
+        struct Worker *const worker = &s_pool.workers[idx];
+        SetEvent( worker->start );
+        WaitForSingleObject( worker->thread, INFINITE );
+        CloseHandle( worker->thread );
+        close_worker( worker );
+    }
+    s_pool.nbWorkers = 0;
+}
+
+
+usize term_workers_count( void )
+{
+    return s_pool.nbWorkers;
+}
+
+
+void term_workers_run( TermJobCb const job, void *const context, usize const nbJobs )
+{
+    assert( job );
+    assert( nbJobs > 0 && nbJobs <= s_pool.nbWorkers + 1 );
+
+    s_pool.job = job;
+    s_pool.context = context;
+
+    HANDLE done[TERM_MAX_ENCODERS - 1];
+    for ( usize idx = 0; idx < nbJobs - 1; ++idx )
+    {
+        done[idx] = s_pool.workers[idx].done;
+        SetEvent( s_pool.workers[idx].start );
+    }
+
+    job( context, 0 );
+
+    if ( nbJobs > 1 )
+    {
+        WaitForMultipleObjects( nbJobs - 1, done, TRUE, INFINITE );
+    }
+}
@@ -0,0 +1,162 @@
+#include "terminal/internal/terminal_writer.h"
+
+#include "time_units.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+
+struct PendingFrame
+{
+    utf16 const *data;
+    usize size;
+};
+
+
+struct Writer
+{
+    HANDLE thread;
+    HANDLE wakeUp; // Auto-reset event, signaled on each submitted frame and when stopping.
+    TermOutputCb outputCb;
+
+    // Single slot exchange: only filled by the main thread when empty, only emptied by the writer.
+    struct PendingFrame pending;
+    atomic_bool hasPending;
+    atomic_bool stopRequested;
+
+    atomic_size_t lastBytesWritten;
+    atomic_size_t lastNbSyscalls;
+    _Atomic nsecond lastWriteDuration;
+    atomic_size_t nbFramesWritten;
+    // Indexed by frame, modulo the history size.
+    _Atomic nsecond writeEnds[TERM_WRITE_TIMES_HISTORY];
+};
+
+
+static struct Writer s_writer;
+
+
+static DWORD WINAPI writer_thread( void *param )
+{
+    for ( ;; )
+    {
+        WaitForSingleObject( s_writer.wakeUp, INFINITE );
+
+        if ( atomic_load_explicit( &s_writer.hasPending, memory_order_acquire ) )
+        {
+            // The slot is released as soon as the frame is copied, the main thread can build the next one meanwhile.
+            struct PendingFrame const frame = s_writer.pending;
+            atomic_store_explicit( &s_writer.hasPending, false, memory_order_release );
+
+            nsecond const writeBegin = time_get_timestamp_nsec();
+            struct TermFrameStats const stats = s_writer.outputCb( frame.data, frame.size );
+            nsecond const writeEnd = time_get_timestamp_nsec();
+
+            atomic_store( &s_writer.lastBytesWritten, stats.bytesWritten );
+            atomic_store( &s_writer.lastNbSyscalls, stats.nbSyscalls );
+            atomic_store( &s_writer.lastWriteDuration, writeEnd - writeBegin );
+            usize const frameIndex = atomic_load( &s_writer.nbFramesWritten );
+            atomic_store( &s_writer.writeEnds[frameIndex % TERM_WRITE_TIMES_HISTORY], writeEnd );
+            atomic_store( &s_writer.nbFramesWritten, frameIndex + 1 );
+        }
+
+        if ( atomic_load( &s_writer.stopRequested ) && !atomic_load( &s_writer.hasPending ) )
+        {
+            return 0;
+        }
+    }
+}
+
+
+bool term_writer_start( TermOutputCb const outputCb )
+{
+    assert( outputCb );
+    assert( s_writer.thread == NULL );
+
+    s_writer.outputCb = outputCb;
+    atomic_store( &s_writer.hasPending, false );
+    atomic_store( &s_writer.stopRequested, false );
+    atomic_store( &s_writer.lastBytesWritten, 0 );
+    atomic_store( &s_writer.lastNbSyscalls, 0 );
+    atomic_store( &s_writer.lastWriteDuration, 0 );
+    atomic_store( &s_writer.nbFramesWritten, 0 );
+
+    s_writer.wakeUp = CreateEventW( NULL, FALSE, FALSE, NULL );
+    if ( s_writer.wakeUp == NULL )
+    {
+        fprintf( stderr, "[ERROR]: CreateEvent failure for the terminal writer. (Code %lu)\n", GetLastError() );
+        return false;
+    }
+
+    s_writer.thread = CreateThread( NULL, 0, writer_thread, NULL, 0, NULL );
+    if ( s_writer.thread == NULL )
+    {
+        fprintf( stderr, "[ERROR]: CreateThread failure for the terminal writer. (Code %lu)\n", GetLastError() );
+        CloseHandle( s_writer.wakeUp );
+        s_writer.wakeUp = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+
+void term_writer_stop( void )
+{
+    if ( s_writer.thread == NULL ) return;
+
+    atomic_store( &s_writer.stopRequested, true );
+    SetEvent( s_writer.wakeUp );
+    WaitForSingleObject( s_writer.thread, INFINITE );
+
+    CloseHandle( s_writer.thread );
+    CloseHandle( s_writer.wakeUp );
+    s_writer.thread = NULL;
+    s_writer.wakeUp = NULL;
+}
+
+
+bool term_writer_is_behind( void )
+{
+    return atomic_load_explicit( &s_writer.hasPending, memory_order_acquire );
+}
+
+
+void term_writer_submit( utf16 const *frame, usize const size )
+{
+    assert( s_writer.thread != NULL );
+    assert( !term_writer_is_behind() );
+
+    s_writer.pending = (struct PendingFrame) { .data = frame, .size = size };
+    atomic_store_explicit( &s_writer.hasPending, true, memory_order_release );
+    SetEvent( s_writer.wakeUp );
+}
+
+
+struct TermFrameStats term_writer_last_frame_stats( void )
+{
+    return (struct TermFrameStats) {
+        .bytesWritten = atomic_load( &s_writer.lastBytesWritten ),
+        .nbSyscalls = atomic_load( &s_writer.lastNbSyscalls ),
+        .writeDuration = atomic_load( &s_writer.lastWriteDuration )
+    };
+}
+
+
+usize term_writer_nb_frames_written( void )
+{
+    return atomic_load( &s_writer.nbFramesWritten );
+}
+
+
+nsecond term_writer_frame_written_time( usize const frameIndex )
+{
+    usize const nbFramesWritten = atomic_load( &s_writer.nbFramesWritten );
+    assert( frameIndex < nbFramesWritten );
+
+    if ( nbFramesWritten - frameIndex > TERM_WRITE_TIMES_HISTORY ) return 0;
+    return atomic_load( &s_writer.writeEnds[frameIndex % TERM_WRITE_TIMES_HISTORY] );
+}
@@ -1,5 +1,5 @@
 #include "terminal/terminal.h"
-
+#include "terminal/terminal_vt.h"
 
 #include <fcntl.h>
 #include <stdio.h>
@@ -14,6 +14,7 @@
 static u32 s_oldInputMode = 0;
 static u32 s_oldOutputMode = 0;
 static atomic_bool s_isInit = false;
+static bool s_isHeadless = false;
 
 static BOOL console_ctrl_handler( DWORD const ctrlType )
 {
@@ -70,6 +71,71 @@ static void reset_console_mode( void )
     SetConsoleMode( term_output_handle(), s_oldOutputMode );
 }
 
+
+static screensize get_screen_size( void const *handle )
+{
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    GetConsoleScreenBufferInfo( (HANDLE)handle, &info );
+
+    u16 const newscreenH = info.srWindow.Bottom - info.srWindow.Top + 1;
+    u16 const newScreenW = info.srWindow.Right - info.srWindow.Left + 1;
+
+    return (screensize) { .w = newScreenW, .h = newscreenH };
+}
+
+
+// Synchronized updates (DEC mode 2026) can't be queried with DECRQM here, as the console input isn't in VT mode
+// and the answer would never reach us. Rely on the environment instead: Windows Terminal supports it.
+// Terminals without support ignore the unknown private mode, so a false positive only costs a few bytes per frame.
+static bool detect_synchronized_update_support( void )
+{
+    return GetEnvironmentVariableA( "WT_SESSION", NULL, 0 ) > 0;
+}
+
+
+static usize get_nb_encoders( void )
+{
+    SYSTEM_INFO info;
+    GetSystemInfo( &info );
+    return min( (usize)info.dwNumberOfProcessors, (usize)TERM_MAX_ENCODERS );
+}
+
+
+// The whole frame is handed to the console in a single call, so the terminal never receives half of a frame.
+static struct TermFrameStats write_console_frame( utf16 const *frame, usize const size )
+{
+    struct TermFrameStats stats = (struct TermFrameStats) {};
+
+    // Make sure nothing written through the CRT is still pending before our frame.
+    fflush( stdout );
+
+    HANDLE const handle = term_output_handle();
+    usize written = 0;
+    while ( written < size )
+    {
+        DWORD nbWritten = 0;
+        BOOL const success = WriteConsoleW( handle, frame + written, (DWORD)( size - written ), &nbWritten, NULL );
+        stats.nbSyscalls += 1;
+
+        if ( !success || nbWritten == 0 )
+        {
+            fprintf( stderr, "[ERROR]: WriteConsoleW failure. (Code %lu)\n", GetLastError() );
+            break;
+        }
+        written += nbWritten;
+    }
+
+    stats.bytesWritten = written * sizeof( utf16 );
+    return stats;
+}
+
+
+static struct TermFrameStats write_headless_frame( utf16 const *frame, usize const size )
+{
+    vt_feed( frame, size );
+    return (struct TermFrameStats) { .bytesWritten = size * sizeof( utf16 ), .nbSyscalls = 1 };
+}
+
 // ////////////////////////////////////////////////////////////////////////////////////////////
 
 bool term_init( char const *optTitle, bool const onDedicatedConsole )
@@ -107,17 +173,66 @@ bool term_init( char const *optTitle, bool const onDedicatedConsole )
 	term_enter_alternate_buffer();
     cursor_hide();
 
-    term_screen_init( term_output_handle() );
+    struct TermOutput const output = (struct TermOutput) {
+        .outputCb = write_console_frame,
+        .synchronizedUpdate = detect_synchronized_update_support(),
+        .async = true,
+        .nbEncoders = get_nb_encoders()
+    };
+    if ( !term_screen_init( get_screen_size( term_output_handle() ), output ) )
+    {
+        term_uninit();
+        return false;
+    }
     screensize const screenSize = term_size();
     SetConsoleScreenBufferSize( term_output_handle(), *(COORD *)&screenSize );
 
     return true;
 }
 
+bool term_init_headless( screensize const size )
+{
+    bool const expectedValue = false;
+    if ( !atomic_compare_exchange_strong( &s_isInit, &expectedValue, true ) )
+    {
+        fprintf( stderr, "[ERROR]: We shouldn't initialize the Console multiple times !\n" );
+        return false;
+    }
+    s_isHeadless = true;
+
+    // Synchronized updates are always enabled, so that the virtual terminal receives every sequence a frame can have.
+    // Frames are written right away, for the virtual terminal to match the screen buffer after each refresh.
+    struct TermOutput const output = (struct TermOutput) {
+        .outputCb = write_headless_frame,
+        .synchronizedUpdate = true,
+        .async = false,
+        .nbEncoders = get_nb_encoders()
+    };
+    if ( !vt_init( size ) || !term_screen_init( size, output ) )
+    {
+        term_uninit();
+        return false;
+    }
+
+    return true;
+}
+
 void term_uninit( void )
 {
     if ( !term_is_init() ) return;
 
+    if ( s_isHeadless )
+    {
+        term_screen_uninit();
+        vt_uninit();
+        s_isHeadless = false;
+        atomic_store( &s_isInit, false );
+        return;
+    }
+
+    // First, so that the frames still in the writer are displayed before leaving the alternate buffer.
+    term_screen_uninit();
+
     SetConsoleCtrlHandler( console_ctrl_handler, FALSE );
     reset_console_mode();
     cursor_show();
@@ -132,6 +247,11 @@ bool term_is_init( void )
     return atomic_load( &s_isInit );
 }
 
+bool term_is_headless( void )
+{
+    return s_isHeadless;
+}
+
 
 bool term_set_title( char const *const title )
 {
@@ -12,16 +12,16 @@ enum AttrInternal
 
 enum // Constants
 {
-    DEFAULT_UNICODE = L' '    
+    DEFAULT_GLYPH = L' '
 };
 
 
-struct Character character_make( utf16 const unicode, struct Style const style )
+struct Character character_make( termglyph const glyph, struct Style const style )
 {
     assert( ( style.attr & AttrInternal_REFRESH_NEEDED ) == 0 );
 
     return (struct Character) {
-        .unicode = unicode,
+        .glyph = glyph,
         .style = style
     };
 }
@@ -29,13 +29,13 @@ struct Character character_make( utf16 const unicode, struct Style const style )
 
 struct Character character_default( void )
 {
-    return character_make( DEFAULT_UNICODE, STYLE_DEFAULT );
+    return character_make( DEFAULT_GLYPH, STYLE_DEFAULT );
 }
 
 
 bool character_equals( struct Character const lhs, struct Character const rhs )
 {
-    return lhs.unicode == rhs.unicode && style_equals( lhs.style, rhs.style );
+    return lhs.glyph == rhs.glyph && style_equals( lhs.style, rhs.style );
 }
 
 
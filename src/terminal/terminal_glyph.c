@@ -0,0 +1,238 @@
+#include "terminal/terminal_glyph.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+
+enum // Constants
+{
+    NB_BMP_UNITS = 0x10000,
+    // Twice the capacity of the table at least, to keep the probing short.
+    NB_BUCKETS = 4096
+};
+
+
+struct Range
+{
+    u32 first;
+    u32 last;
+};
+
+
+// Code points displayed on two cells: East Asian Width W and F, from EastAsianWidth.txt of Unicode 14.0. The reserved
+// code points of the CJK ideographs blocks and planes 2 and 3 are included, W by default. Sorted.
+static struct Range const S_WIDE_RANGES[] =
+{
+    { 0x1100, 0x115F }, { 0x231A, 0x231B }, { 0x2329, 0x232A }, { 0x23E9, 0x23EC }, { 0x23F0, 0x23F0 },
+    { 0x23F3, 0x23F3 }, { 0x25FD, 0x25FE }, { 0x2614, 0x2615 }, { 0x2648, 0x2653 }, { 0x267F, 0x267F },
+    { 0x2693, 0x2693 }, { 0x26A1, 0x26A1 }, { 0x26AA, 0x26AB }, { 0x26BD, 0x26BE }, { 0x26C4, 0x26C5 },
+    { 0x26CE, 0x26CE }, { 0x26D4, 0x26D4 }, { 0x26EA, 0x26EA }, { 0x26F2, 0x26F3 }, { 0x26F5, 0x26F5 },
+    { 0x26FA, 0x26FA }, { 0x26FD, 0x26FD }, { 0x2705, 0x2705 }, { 0x270A, 0x270B }, { 0x2728, 0x2728 },
+    { 0x274C, 0x274C }, { 0x274E, 0x274E }, { 0x2753, 0x2755 }, { 0x2757, 0x2757 }, { 0x2795, 0x2797 },
+    { 0x27B0, 0x27B0 }, { 0x27BF, 0x27BF }, { 0x2B1B, 0x2B1C }, { 0x2B50, 0x2B50 }, { 0x2B55, 0x2B55 },
+    { 0x2E80, 0x2E99 }, { 0x2E9B, 0x2EF3 }, { 0x2F00, 0x2FD5 }, { 0x2FF0, 0x2FFB }, { 0x3000, 0x303E },
+    { 0x3041, 0x3096 }, { 0x3099, 0x30FF }, { 0x3105, 0x312F }, { 0x3131, 0x318E }, { 0x3190, 0x31E3 },
+    { 0x31F0, 0x321E }, { 0x3220, 0x3247 }, { 0x3250, 0x4DBF }, { 0x4E00, 0xA48C }, { 0xA490, 0xA4C6 },
+    { 0xA960, 0xA97C }, { 0xAC00, 0xD7A3 }, { 0xF900, 0xFAFF }, { 0xFE10, 0xFE19 }, { 0xFE30, 0xFE52 },
+    { 0xFE54, 0xFE66 }, { 0xFE68, 0xFE6B }, { 0xFF01, 0xFF60 }, { 0xFFE0, 0xFFE6 },
+    { 0x16FE0, 0x16FE4 }, { 0x16FF0, 0x16FF1 }, { 0x17000, 0x187F7 }, { 0x18800, 0x18CD5 }, { 0x18D00, 0x18D08 },
+    { 0x1AFF0, 0x1AFF3 }, { 0x1AFF5, 0x1AFFB }, { 0x1AFFD, 0x1AFFE }, { 0x1B000, 0x1B122 }, { 0x1B150, 0x1B152 },
+    { 0x1B164, 0x1B167 }, { 0x1B170, 0x1B2FB }, { 0x1F004, 0x1F004 }, { 0x1F0CF, 0x1F0CF }, { 0x1F18E, 0x1F18E },
+    { 0x1F191, 0x1F19A }, { 0x1F200, 0x1F202 }, { 0x1F210, 0x1F23B }, { 0x1F240, 0x1F248 }, { 0x1F250, 0x1F251 },
+    { 0x1F260, 0x1F265 }, { 0x1F300, 0x1F320 }, { 0x1F32D, 0x1F335 }, { 0x1F337, 0x1F37C }, { 0x1F37E, 0x1F393 },
+    { 0x1F3A0, 0x1F3CA }, { 0x1F3CF, 0x1F3D3 }, { 0x1F3E0, 0x1F3F0 }, { 0x1F3F4, 0x1F3F4 }, { 0x1F3F8, 0x1F43E },
+    { 0x1F440, 0x1F440 }, { 0x1F442, 0x1F4FC }, { 0x1F4FF, 0x1F53D }, { 0x1F54B, 0x1F54E }, { 0x1F550, 0x1F567 },
+    { 0x1F57A, 0x1F57A }, { 0x1F595, 0x1F596 }, { 0x1F5A4, 0x1F5A4 }, { 0x1F5FB, 0x1F64F }, { 0x1F680, 0x1F6C5 },
+    { 0x1F6CC, 0x1F6CC }, { 0x1F6D0, 0x1F6D2 }, { 0x1F6D5, 0x1F6D7 }, { 0x1F6DD, 0x1F6DF }, { 0x1F6EB, 0x1F6EC },
+    { 0x1F6F4, 0x1F6FC }, { 0x1F7E0, 0x1F7EB }, { 0x1F7F0, 0x1F7F0 }, { 0x1F90C, 0x1F93A }, { 0x1F93C, 0x1F945 },
+    { 0x1F947, 0x1F9FF }, { 0x1FA70, 0x1FA74 }, { 0x1FA78, 0x1FA7C }, { 0x1FA80, 0x1FA86 }, { 0x1FA90, 0x1FAAC },
+    { 0x1FAB0, 0x1FABA }, { 0x1FAC0, 0x1FAC5 }, { 0x1FAD0, 0x1FAD9 }, { 0x1FAE0, 0x1FAE7 }, { 0x1FAF0, 0x1FAF6 },
+    { 0x20000, 0x2FFFD }, { 0x30000, 0x3FFFD }
+};
+
+
+// Code units attached to the glyph before them. Sorted.
+static struct Range const S_COMBINING_RANGES[] =
+{
+    { 0x0300, 0x036F }, { 0x1AB0, 0x1AFF }, { 0x1DC0, 0x1DFF }, { 0x200D, 0x200D }, { 0x20D0, 0x20FF },
+    { 0xFE00, 0xFE0F }, { 0xFE20, 0xFE2F }
+};
+
+
+struct InternedGlyph
+{
+    utf16 units[GLYPH_MAX_UNITS];
+    u8 nbUnits;
+};
+
+
+struct GlyphTable
+{
+    // One bit per glyph ID, set for the wide ones.
+    u8 wide[NB_BMP_UNITS / 8];
+
+    struct InternedGlyph glyphs[GLYPH_MAX_INTERNED];
+    usize nbGlyphs;
+    // Interned index + 1, 0 for an empty bucket.
+    u16 buckets[NB_BUCKETS];
+
+    bool isInit;
+    bool fullReported;
+};
+
+
+static struct GlyphTable s_table;
+
+
+static inline bool is_high_surrogate( utf16 const unit ) { return unit >= 0xD800 && unit <= 0xDBFF; }
+static inline bool is_low_surrogate( utf16 const unit )  { return unit >= 0xDC00 && unit <= 0xDFFF; }
+static inline bool is_surrogate( utf16 const unit )      { return unit >= 0xD800 && unit <= 0xDFFF; }
+
+
+static bool in_ranges( struct Range const *ranges, usize const nbRanges, u32 const codepoint )
+{
+    usize low = 0;
+    usize high = nbRanges;
+    while ( low < high )
+    {
+        usize const mid = ( low + high ) / 2;
+        if ( codepoint < ranges[mid].first ) high = mid;
+        else if ( codepoint > ranges[mid].last ) low = mid + 1;
+        else return true;
+    }
+    return false;
+}
+
+
+static inline void set_wide( termglyph const glyph )
+{
+    s_table.wide[glyph >> 3] |= (u8)( 1 << ( glyph & 7 ) );
+}
+
+
+void glyph_table_init( void )
+{
+    if ( s_table.isInit ) return;
+
+    for ( usize unit = 0; unit < NB_BMP_UNITS; ++unit )
+    {
+        if ( !is_surrogate( unit ) && in_ranges( S_WIDE_RANGES, ARR_COUNT( S_WIDE_RANGES ), unit ) )
+        {
+            set_wide( unit );
+        }
+    }
+    s_table.isInit = true;
+}
+
+
+static u32 hash_units( utf16 const *units, usize const nbUnits )
+{
+    // FNV-1a
+    u32 hash = 2166136261u;
+    for ( usize idx = 0; idx < nbUnits; ++idx )
+    {
+        hash = ( hash ^ units[idx] ) * 16777619u;
+    }
+    return hash;
+}
+
+
+// The width of a sequence is the one of its first code point.
+static bool is_wide_sequence( utf16 const *units, usize const nbUnits )
+{
+    u32 codepoint = units[0];
+    if ( nbUnits > 1 && is_high_surrogate( units[0] ) && is_low_surrogate( units[1] ) )
+    {
+        codepoint = 0x10000 + ( ( (u32)units[0] - 0xD800 ) << 10 ) + ( units[1] - 0xDC00 );
+    }
+    return in_ranges( S_WIDE_RANGES, ARR_COUNT( S_WIDE_RANGES ), codepoint );
+}
+
+
+termglyph glyph_intern( utf16 const *units, usize nbUnits )
+{
+    assert( s_table.isInit );
+    assert( nbUnits > 0 );
+
+    if ( nbUnits == 1 && !is_surrogate( units[0] ) ) return units[0];
+    if ( is_low_surrogate( units[0] ) || ( is_high_surrogate( units[0] ) && ( nbUnits == 1 || !is_low_surrogate( units[1] ) ) ) )
+    {
+        return GLYPH_REPLACEMENT;
+    }
+    nbUnits = min( nbUnits, (usize)GLYPH_MAX_UNITS );
+
+    usize bucket = hash_units( units, nbUnits ) % NB_BUCKETS;
+    while ( s_table.buckets[bucket] != 0 )
+    {
+        usize const idx = s_table.buckets[bucket] - 1;
+        struct InternedGlyph const *interned = &s_table.glyphs[idx];
+        if ( interned->nbUnits == nbUnits && memcmp( interned->units, units, nbUnits * sizeof( utf16 ) ) == 0 )
+        {
+            return GLYPH_FIRST_INTERNED + idx;
+        }
+        bucket = ( bucket + 1 ) % NB_BUCKETS;
+    }
+
+    if ( s_table.nbGlyphs == GLYPH_MAX_INTERNED )
+    {
+        if ( !s_table.fullReported )
+        {
+            fprintf( stderr, "[ERROR]: Can't intern more than %u glyphs, the next ones will be replaced.\n", GLYPH_MAX_INTERNED );
+            s_table.fullReported = true;
+        }
+        return GLYPH_REPLACEMENT;
+    }
+
+    usize const idx = s_table.nbGlyphs++;
+    struct InternedGlyph *const interned = &s_table.glyphs[idx];
+    memcpy( interned->units, units, nbUnits * sizeof( utf16 ) );
+    interned->nbUnits = nbUnits;
+    s_table.buckets[bucket] = idx + 1;
+
+    termglyph const glyph = GLYPH_FIRST_INTERNED + idx;
+    if ( is_wide_sequence( units, nbUnits ) ) set_wide( glyph );
+    return glyph;
+}
+
+
+usize glyph_decode( utf16 const *text, usize const size, termglyph *const outGlyph )
+{
+    assert( size > 0 );
+
+    usize length = ( size > 1 && is_high_surrogate( text[0] ) && is_low_surrogate( text[1] ) ) ? 2 : 1;
+    while ( length < size && glyph_is_combining( text[length] ) ) ++length;
+
+    *outGlyph = ( length == 1 && !is_surrogate( text[0] ) ) ? text[0] : glyph_intern( text, length );
+    return length;
+}
+
+
+usize glyph_width( termglyph const glyph )
+{
+    return ( ( s_table.wide[glyph >> 3] >> ( glyph & 7 ) ) & 1 ) ? 2 : 1;
+}
+
+
+bool glyph_is_combining( utf16 const unit )
+{
+    return unit >= 0x0300 && in_ranges( S_COMBINING_RANGES, ARR_COUNT( S_COMBINING_RANGES ), unit );
+}
+
+
+usize glyph_encode( termglyph const glyph, utf16 *const outBuffer )
+{
+    assert( glyph != GLYPH_WIDE_TAIL );
+
+    if ( !is_surrogate( glyph ) )
+    {
+        outBuffer[0] = glyph;
+        return 1;
+    }
+
+    struct InternedGlyph const *interned = &s_table.glyphs[glyph - GLYPH_FIRST_INTERNED];
+    memcpy( outBuffer, interned->units, interned->nbUnits * sizeof( utf16 ) );
+    return interned->nbUnits;
+}
@@ -0,0 +1,216 @@
+#include "terminal/terminal_layer.h"
+#include "terminal/internal/terminal_layers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+
+struct TermLayer
+{
+    screenpos ul;
+    vec2u16 size;
+    enum TermLayerDepth depth;
+    bool visible;
+    struct Character characters[]; // Row by row
+};
+
+
+// Sorted from the bottom to the top.
+static struct TermLayer *s_layers[TERM_MAX_LAYERS];
+static usize s_nbLayers = 0;
+static usize s_nbVisibleLayers = 0;
+
+
+static inline bool is_inside( struct TermLayer const *layer, screenpos const pos )
+{
+    return pos.x >= layer->ul.x && (usize)pos.x < (usize)layer->ul.x + layer->size.w
+        && pos.y >= layer->ul.y && (usize)pos.y < (usize)layer->ul.y + layer->size.h;
+}
+
+
+static void invalidate_footprint( struct TermLayer const *layer )
+{
+    if ( layer->visible )
+    {
+        term_invalidate_area( layer->ul, layer->size );
+    }
+}
+
+
+struct TermLayer *term_layer_create( vec2u16 const size, enum TermLayerDepth const depth )
+{
+    assert( size.w > 0 && size.h > 0 );
+
+    if ( s_nbLayers == TERM_MAX_LAYERS )
+    {
+        fprintf( stderr, "[ERROR]: Can't create more than %u terminal layers.\n", TERM_MAX_LAYERS );
+        return NULL;
+    }
+
+    usize const area = (usize)size.w * size.h;
+    struct TermLayer *const layer = malloc( sizeof( struct TermLayer ) + area * sizeof( struct Character ) );
+    if ( !layer )
+    {
+        fprintf( stderr, "[ERROR]: Failed to allocate a terminal layer of %ux%u.\n", size.w, size.h );
+        return NULL;
+    }
+
+    layer->ul = SCREENPOS( 1, 1 );
+    layer->size = size;
+    layer->depth = depth;
+    layer->visible = false;
+    for ( usize idx = 0; idx < area; ++idx )
+    {
+        layer->characters[idx] = character_default();
+    }
+
+    // Above every layer of the same depth.
+    usize insertAt = s_nbLayers;
+    while ( insertAt > 0 && s_layers[insertAt - 1]->depth > depth ) --insertAt;
+
+    memmove( &s_layers[insertAt + 1], &s_layers[insertAt], ( s_nbLayers - insertAt ) * sizeof( struct TermLayer * ) );
+    s_layers[insertAt] = layer;
+    s_nbLayers += 1;
+
+    return layer;
+}
+
+
+void term_layer_destroy( struct TermLayer *const layer )
+{
+    if ( !layer ) return;
+
+    term_layer_hide( layer );
+
+    for ( usize idx = 0; idx < s_nbLayers; ++idx )
+    {
+        if ( s_layers[idx] != layer ) continue;
+
+        memmove( &s_layers[idx], &s_layers[idx + 1], ( s_nbLayers - idx - 1 ) * sizeof( struct TermLayer * ) );
+        s_nbLayers -= 1;
+        break;
+    }
+
+    free( layer );
+}
+
+
+void term_layer_set_content( struct TermLayer *const layer, struct Character const *characters )
+{
+    assert( layer && characters );
+
+    for ( usize y = 0; y < layer->size.h; ++y )
+    {
+        for ( usize x = 0; x < layer->size.w; ++x )
+        {
+            usize const idx = y * layer->size.w + x;
+            assert( !character_needs_refresh( characters[idx] ) );
+            if ( character_equals( layer->characters[idx], characters[idx] ) ) continue;
+
+            layer->characters[idx] = characters[idx];
+            if ( layer->visible )
+            {
+                term_invalidate_area( SCREENPOS( layer->ul.x + x, layer->ul.y + y ), VEC2U16( 1, 1 ) );
+            }
+        }
+    }
+}
+
+
+void term_layer_move( struct TermLayer *const layer, screenpos const ul )
+{
+    assert( layer );
+    if ( layer->ul.raw == ul.raw ) return;
+
+    // What was under the layer comes back, and the layer shows up on top of its new position.
+    invalidate_footprint( layer );
+    layer->ul = ul;
+    invalidate_footprint( layer );
+}
+
+
+void term_layer_show( struct TermLayer *const layer )
+{
+    assert( layer );
+    if ( layer->visible ) return;
+
+    layer->visible = true;
+    s_nbVisibleLayers += 1;
+    invalidate_footprint( layer );
+}
+
+
+void term_layer_hide( struct TermLayer *const layer )
+{
+    assert( layer );
+    if ( !layer->visible ) return;
+
+    invalidate_footprint( layer );
+    layer->visible = false;
+    s_nbVisibleLayers -= 1;
+}
+
+
+bool term_layers_character_at( screenpos const pos, struct Character *const outCharacter )
+{
+    if ( s_nbVisibleLayers == 0 ) return false;
+
+    for ( usize idx = s_nbLayers; idx > 0; --idx )
+    {
+        struct TermLayer const *layer = s_layers[idx - 1];
+        if ( !layer->visible || !is_inside( layer, pos ) ) continue;
+
+        *outCharacter = layer->characters[( pos.y - layer->ul.y ) * layer->size.w + ( pos.x - layer->ul.x )];
+        return true;
+    }
+    return false;
+}
+
+
+void term_layers_on_scroll( u16 const top, u16 const bottom, enum ScrollDirection const direction, u16 const nbLines )
+{
+    if ( s_nbVisibleLayers == 0 ) return;
+
+    for ( usize idx = 0; idx < s_nbLayers; ++idx )
+    {
+        struct TermLayer const *layer = s_layers[idx];
+        int const layerTop = layer->ul.y;
+        int const layerBottom = layerTop + layer->size.h - 1;
+        if ( !layer->visible || layerBottom < top || layerTop > bottom ) continue;
+
+        // The layer must be drawn again at its place, and the lines its characters were moved to as well.
+        invalidate_footprint( layer );
+
+        int const shift = ( direction == ScrollDirection_UP ) ? -(int)nbLines : (int)nbLines;
+        int const movedTop = max( layerTop + shift, (int)top );
+        int const movedBottom = min( layerBottom + shift, (int)bottom );
+        if ( movedTop > movedBottom ) continue;
+
+        term_invalidate_area( SCREENPOS( layer->ul.x, movedTop ), VEC2U16( layer->size.w, movedBottom - movedTop + 1 ) );
+    }
+}
+
+
+void term_layers_on_resize( void )
+{
+    for ( usize idx = 0; idx < s_nbLayers; ++idx )
+    {
+        invalidate_footprint( s_layers[idx] );
+    }
+}
+
+
+void term_layers_destroy_all( void )
+{
+    for ( usize idx = 0; idx < s_nbLayers; ++idx )
+    {
+        free( s_layers[idx] );
+        s_layers[idx] = NULL;
+    }
+    s_nbLayers = 0;
+    s_nbVisibleLayers = 0;
+}
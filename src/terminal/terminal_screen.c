@@ -1,22 +1,87 @@
 #include "terminal/terminal.h"
 #include "terminal/internal/terminal_sequence.h"
+#include "terminal/internal/terminal_writer.h"
+#include "terminal/internal/terminal_layers.h"
+#include "terminal/internal/terminal_workers.h"
 #include "terminal/terminal_character.h"
 #include "game.h"
 #include "events.h"
+#include "trace.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
 
-struct Screen
+struct ClearedSpan
+{
+    u16 begin;
+    u16 end;
+};
+
+
+// Columns of a row where characters may need a refresh, sorted and without any overlap.
+// When there are too many of them, the closest spans are merged: the refresh pass only visits them, and still
+// checks each character on its way.
+struct DamagedRow
 {
-    union
+    struct
     {
-        struct Character raw[GAME_SIZE_AREA];
-        struct Character content[GAME_SIZE_HEIGHT][GAME_SIZE_WIDTH];
-    };
+        u16 begin;
+        u16 end;
+    } spans[TERM_MAX_DAMAGE_SPANS_PER_ROW];
+    u8 nbSpans;
+};
+
+
+// The grid is at least as big as the game area, as widgets only draw their content once and it must not be lost when
+// the terminal is temporarily smaller. It grows along with the terminal past that.
+struct Screen
+{
+    struct Character *cells;
+    struct Character **rows; // Point into cells, swapping two rows doesn't need to move any character.
+    struct Character *scratch; // Same size as cells, used when shifting content around.
+
+    // Per row, characters that became visible after the terminal has been resized, and that the terminal may
+    // display as blank whatever their refresh state. Resolved when the row is refreshed.
+    struct ClearedSpan *clearedSpans;
+
+    // Per row, what changed since the last refresh.
+    struct DamagedRow *damage;
+
+    screensize size;
+};
+
+
+struct ScrollRequest
+{
+    // Lines of the scroll region, starting at 1 as for a screenpos.
+    u16 top;
+    u16 bottom;
+    enum ScrollDirection direction;
+    u16 nbLines;
+};
+
+
+struct CosmeticArea
+{
+    screenpos ul;
+    vec2u16 size;
+};
+
+
+// Decides if the terminal keeps up with the frames, from the backlog of the writer and the duration of the writes.
+struct LinkMonitor
+{
+    bool saturated;
+    usize nbCongestedRefreshes; // In a row
+    usize nbClearRefreshes;     // In a row
+    usize nbFramesWrittenSeen;  // Only new writes are measured.
+    usize nbFramesBuilt;        // Picks the frames where the cosmetic areas are sent while saturated.
 };
 
 
@@ -24,207 +89,1348 @@ struct ScreenInfo
 {
     struct Screen screen;
 
-    // While the first is the current size of the terminal,
-    // The second one is limited to the boundaries of the game: 120x30.
+    struct TermOutput output;
+    struct TermFrameStats lastFrameStats;
+    usize nbDroppedFrames; // Since the last frame submitted to the writer.
+    usize nbDroppedBeforeLastFrame;
+    usize nbFramesWritten; // Synchronous output only, the writer counts its own.
+    nsecond writeEnds[TERM_WRITE_TIMES_HISTORY]; // Synchronous output only as well.
+    usize nbFramesSent;
+
+    struct LinkMonitor link;
+    struct CosmeticArea cosmeticAreas[TERM_MAX_COSMETIC_AREAS];
+
+    u8 damageOwner;
+    struct TermDamageTotals damageTotals[TERM_MAX_DAMAGE_OWNERS];
+    usize nbCosmeticAreas;
+
+    // Scrolls requested since the last refresh, sent to the terminal before the content of the frame.
+    struct ScrollRequest scrolls[TERM_MAX_SCROLLS_PER_FRAME];
+    usize nbScrolls;
+
+    // Frame sent to the terminal, grown whenever a frame could not fit in it.
+    utf16 *frame;
+    usize frameCapacity;
+
+    // With an asynchronous output, the frame the writer may still be working on. Swapped with the one above
+    // once a frame has been submitted.
+    utf16 *frontFrame;
+    usize frontFrameCapacity;
+
+    // Encoded separately by the workers, then copied after the first band in the frame. The first one is unused,
+    // as the first band is directly encoded in the frame.
+    utf16 *bandFrames[TERM_MAX_ENCODERS];
+    usize bandFrameCapacities[TERM_MAX_ENCODERS];
+
+    // Current size of the terminal. Only the part of the grid within it is displayed.
     screensize size;
-    screensize supportedGameSize;
 };
 
 
 static struct ScreenInfo s_screenInfo;
 
 
-static screensize game_size_from_screen( screensize const screenSize )
+static screensize grid_size_from_screen( screensize const screenSize )
+{
+    return (screensize) {
+        .h = max( screenSize.h, GAME_SIZE_HEIGHT ),
+        .w = max( screenSize.w, GAME_SIZE_WIDTH )
+    };
+}
+
+
+static screensize visible_size( void )
 {
     return (screensize) {
-        .h = min( screenSize.h, GAME_SIZE_HEIGHT ),
-        .w = min( screenSize.w, GAME_SIZE_WIDTH )
+        .h = min( s_screenInfo.size.h, s_screenInfo.screen.size.h ),
+        .w = min( s_screenInfo.size.w, s_screenInfo.screen.size.w )
+    };
+}
+
+
+static void screen_free( struct Screen *const screen )
+{
+    free( screen->cells );
+    free( screen->rows );
+    free( screen->scratch );
+    free( screen->clearedSpans );
+    free( screen->damage );
+    *screen = (struct Screen) {};
+}
+
+
+// Allocates the grid in one go, with every character set to default.
+static bool screen_alloc( struct Screen *const screen, screensize const size )
+{
+    usize const area = (usize)size.w * size.h;
+
+    *screen = (struct Screen) {
+        .cells = malloc( area * sizeof( struct Character ) ),
+        .rows = malloc( size.h * sizeof( struct Character * ) ),
+        .scratch = malloc( area * sizeof( struct Character ) ),
+        .clearedSpans = calloc( size.h, sizeof( struct ClearedSpan ) ),
+        .damage = calloc( size.h, sizeof( struct DamagedRow ) ),
+        .size = size
     };
+
+    if ( !screen->cells || !screen->rows || !screen->scratch || !screen->clearedSpans || !screen->damage )
+    {
+        screen_free( screen );
+        return false;
+    }
+
+    for ( usize y = 0; y < size.h; ++y )
+    {
+        screen->rows[y] = &screen->cells[y * size.w];
+    }
+    for ( usize idx = 0; idx < area; ++idx )
+    {
+        screen->cells[idx] = character_default();
+    }
+
+    return true;
+}
+
+
+static void damage_row( struct DamagedRow *const row, u16 begin, u16 end )
+{
+    // Every span touching the new one is merged into it.
+    usize first = 0;
+    while ( first < row->nbSpans && row->spans[first].end < begin ) ++first;
+
+    usize last = first;
+    while ( last < row->nbSpans && row->spans[last].begin <= end )
+    {
+        begin = min( begin, row->spans[last].begin );
+        end = max( end, row->spans[last].end );
+        ++last;
+    }
+
+    if ( last > first )
+    {
+        row->spans[first].begin = begin;
+        row->spans[first].end = end;
+        memmove( &row->spans[first + 1], &row->spans[last], ( row->nbSpans - last ) * sizeof( row->spans[0] ) );
+        row->nbSpans -= last - first - 1;
+        return;
+    }
+
+    if ( row->nbSpans < TERM_MAX_DAMAGE_SPANS_PER_ROW )
+    {
+        memmove( &row->spans[first + 1], &row->spans[first], ( row->nbSpans - first ) * sizeof( row->spans[0] ) );
+        row->spans[first].begin = begin;
+        row->spans[first].end = end;
+        row->nbSpans += 1;
+        return;
+    }
+
+    // No room left, the new span extends the closest one instead.
+    bool const extendLeft = first == row->nbSpans
+        || ( first > 0 && begin - row->spans[first - 1].end <= row->spans[first].begin - end );
+
+    if ( extendLeft )
+        row->spans[first - 1].end = end;
+    else
+        row->spans[first].begin = begin;
+}
+
+
+// Area given in grid indexes, already within the grid.
+static void add_damage( usize const left, usize const top, usize const width, usize const height )
+{
+    if ( width == 0 || height == 0 ) return;
+
+    for ( usize y = top; y < top + height; ++y )
+    {
+        damage_row( &s_screenInfo.screen.damage[y], left, left + width );
+    }
+
+    struct TermDamageTotals *const totals = &s_screenInfo.damageTotals[s_screenInfo.damageOwner];
+    totals->nbRects += 1;
+    totals->nbCells += width * height;
+}
+
+
+// Before a span is replaced or its row moved, turn it into refresh flags.
+// Depending on the terminal, the span either shows blanks or what was there before it got hidden. Both match
+// the buffer for blank characters that weren't modified since, so these are the only ones that can be skipped.
+static void resolve_cleared_span( usize const y )
+{
+    struct ClearedSpan *const span = &s_screenInfo.screen.clearedSpans[y];
+    struct Character *const row = s_screenInfo.screen.rows[y];
+    struct Character const blank = character_default();
+
+    for ( usize x = span->begin; x < span->end; ++x )
+    {
+        if ( !character_equals( row[x], blank ) )
+        {
+            character_mark_as_refresh_needed( &row[x] );
+        }
+    }
+
+    add_damage( span->begin, y, span->end - span->begin, 1 );
+    *span = (struct ClearedSpan) {};
+}
+
+
+static void set_cleared_span( usize const y, u16 const begin, u16 const end )
+{
+    if ( begin >= end ) return;
+
+    resolve_cleared_span( y );
+    s_screenInfo.screen.clearedSpans[y] = (struct ClearedSpan) { .begin = begin, .end = end };
 }
 
 
-static screensize get_screen_size( void const *handle )
+static bool reserve_buffer( utf16 **const buffer, usize *const bufferCapacity, usize const capacity )
 {
-    CONSOLE_SCREEN_BUFFER_INFO info;
-    GetConsoleScreenBufferInfo( (HANDLE)handle, &info );
+    if ( capacity <= *bufferCapacity ) return true;
+
+    usize newCapacity = max( *bufferCapacity, (usize)TERM_REFRESH_BUFFER_SIZE );
+    while ( newCapacity < capacity ) newCapacity *= 2;
+
+    utf16 *const newBuffer = realloc( *buffer, newCapacity * sizeof( utf16 ) );
+    if ( !newBuffer ) return false;
 
-    u16 const newscreenH = info.srWindow.Bottom - info.srWindow.Top + 1;
-    u16 const newScreenW = info.srWindow.Right - info.srWindow.Left + 1;
+    *buffer = newBuffer;
+    *bufferCapacity = newCapacity;
+    return true;
+}
 
-    return (screensize) { .w = newScreenW, .h = newscreenH };
+
+static bool reserve_frame( usize const capacity )
+{
+    return reserve_buffer( &s_screenInfo.frame, &s_screenInfo.frameCapacity, capacity );
 }
 
 
 static struct Character *get_character_at_pos( screenpos const pos )
 {
     // While our indexes begin at 0:0, a screenpos starts at 1:1
-    return &s_screenInfo.screen.content[pos.y - 1][pos.x - 1];
+    return &s_screenInfo.screen.rows[pos.y - 1][pos.x - 1];
 }
 
 
-bool term_screen_init( void const *handle )
+bool term_screen_init( screensize const screenSize, struct TermOutput const output )
 {
-    screensize const screenSize = get_screen_size( handle );
+    assert( output.outputCb );
 
+    glyph_table_init();
+
+    if ( !screen_alloc( &s_screenInfo.screen, grid_size_from_screen( screenSize ) ) || !reserve_frame( TERM_REFRESH_BUFFER_SIZE ) )
+    {
+        fprintf( stderr, "[ERROR]: Failed to allocate the screen buffers.\n" );
+        term_screen_uninit();
+        return false;
+    }
+
+    s_screenInfo.output = output;
     s_screenInfo.size = screenSize;
-    s_screenInfo.supportedGameSize = game_size_from_screen( screenSize );
-    term_clear();
+    s_screenInfo.nbFramesWritten = 0;
+    s_screenInfo.nbFramesSent = 0;
+
+    if ( output.async && !term_writer_start( output.outputCb ) )
+    {
+        term_screen_uninit();
+        return false;
+    }
+
+    usize const nbEncoders = min( output.nbEncoders, (usize)TERM_MAX_ENCODERS );
+    if ( nbEncoders > 1 && !term_workers_start( nbEncoders - 1 ) )
+    {
+        term_screen_uninit();
+        return false;
+    }
 
     return true;
 }
 
 
-int term_write( utf16 const *format, ... )
+void term_screen_uninit( void )
 {
-    static utf16 buffer[TERM_WRITE_BUFFER_SIZE] = {};
+    // Before anything is freed, as the writer may still be working on a frame.
+    if ( s_screenInfo.output.async )
+    {
+        term_writer_stop();
+        s_screenInfo.output.async = false;
+    }
+    term_workers_stop();
 
-    va_list args;
-	va_start( args, format );
-    int const bufferSize = vsnwprintf( buffer, ARR_COUNT( buffer ), format, args );
-	va_end( args );
+    screen_free( &s_screenInfo.screen );
 
-    assert( bufferSize > 0 ); // Otherwise, we may have busted the limit of the buffer, or a bad format has been given.
+    free( s_screenInfo.frame );
+    s_screenInfo.frame = NULL;
+    s_screenInfo.frameCapacity = 0;
+
+    free( s_screenInfo.frontFrame );
+    s_screenInfo.frontFrame = NULL;
+    s_screenInfo.frontFrameCapacity = 0;
+
+    for ( usize idx = 1; idx < TERM_MAX_ENCODERS; ++idx )
+    {
+        free( s_screenInfo.bandFrames[idx] );
+        s_screenInfo.bandFrames[idx] = NULL;
+        s_screenInfo.bandFrameCapacities[idx] = 0;
+    }
+
+    s_screenInfo.link = (struct LinkMonitor) {};
+    s_screenInfo.nbCosmeticAreas = 0;
+    s_screenInfo.damageOwner = 0;
+    memset( s_screenInfo.damageTotals, 0, sizeof( s_screenInfo.damageTotals ) );
+
+    term_layers_destroy_all();
+}
+
+
+// Bounds of the characters modified by a write, in grid indexes. Reported as a single damaged area.
+struct ChangedBounds
+{
+    usize left;
+    usize top;
+    usize right;  // Excluded
+    usize bottom; // Excluded
+};
+
+
+static inline bool put_character( struct Character *const current, struct Character const newC )
+{
+    // Don't refresh something that didn't change. It's just wasted time.
+    if ( character_equals( *current, newC ) ) return false;
+
+    *current = newC;
+    character_mark_as_refresh_needed( current );
+    return true;
+}
+
+
+static inline void extend_bounds( struct ChangedBounds *const bounds, usize const x, usize const y )
+{
+    bounds->left = min( bounds->left, x );
+    bounds->top = min( bounds->top, y );
+    bounds->right = max( bounds->right, x + 1 );
+    bounds->bottom = max( bounds->bottom, y + 1 );
+}
 
-    u16 const maxWidth = s_screenInfo.supportedGameSize.w;
 
-    for ( usize idx = 0; idx < (usize)bufferSize; ++idx )
+static void damage_bounds( struct ChangedBounds const bounds )
+{
+    if ( bounds.right <= bounds.left ) return;
+    add_damage( bounds.left, bounds.top, bounds.right - bounds.left, bounds.bottom - bounds.top );
+}
+
+
+static inline struct ChangedBounds no_bounds( void )
+{
+    return (struct ChangedBounds) { .left = USHRT_MAX, .top = USHRT_MAX, .right = 0, .bottom = 0 };
+}
+
+
+static inline void put_and_extend( struct Character *const row, usize const x, usize const y, struct Character const character, struct ChangedBounds *const bounds )
+{
+    if ( put_character( &row[x], character ) )
     {
-        screenpos const cursorPos = cursor_pos();
-  
-        // We have reached the end of the game screen, and we don't want to continue on the next line either.
-        // So stop prematurely here.
-        if ( cursorPos.x > maxWidth ) break;
+        extend_bounds( bounds, x, y );
+    }
+}
+
+
+// What is left of a wide glyph once its other half is overwritten.
+static inline struct Character blank_half( struct Character half )
+{
+    character_refreshed( &half );
+    half.glyph = L' ';
+    return half;
+}
+
 
-        cursor_move_right_by( 1 );
+// Wide glyphs cover two cells, the second one holding GLYPH_WIDE_TAIL. As terminals do, the other half of a wide
+// glyph is blanked when one of its halves is overwritten. Returns the number of cells covered by the character.
+static usize put_glyph( struct Character *const row, usize const x, usize const y, struct Character character, struct ChangedBounds *const bounds )
+{
+    usize const rowWidth = s_screenInfo.screen.size.w;
 
-        struct Character *const oldC = get_character_at_pos( cursorPos );
-        struct Character newC = (struct Character) {
-            .unicode = buffer[idx],
-            .style = style_current()
-        };
+    usize width = glyph_width( character.glyph );
+    if ( width > 1 && x + 1 >= rowWidth )
+    {
+        // No room left for its second half on this line.
+        character.glyph = L' ';
+        width = 1;
+    }
 
-        // Don't refresh something that didn't change. It's just wasted time.
-        if ( character_equals( *oldC, newC ) ) continue;
+    // A tail split from its lead, by a scroll of part of the row, is simply replaced: the cell before it is another glyph.
+    if ( row[x].glyph == GLYPH_WIDE_TAIL && x > 0 && glyph_width( row[x - 1].glyph ) > 1 )
+    {
+        put_and_extend( row, x - 1, y, blank_half( row[x - 1] ), bounds );
+    }
+    usize const last = x + width - 1;
+    if ( last + 1 < rowWidth && row[last + 1].glyph == GLYPH_WIDE_TAIL )
+    {
+        put_and_extend( row, last + 1, y, blank_half( row[last + 1] ), bounds );
+    }
 
-        *oldC = newC;
-        character_mark_as_refresh_needed( oldC );
+    put_and_extend( row, x, y, character, bounds );
+    if ( width > 1 )
+    {
+        put_and_extend( row, x + 1, y, character_make( GLYPH_WIDE_TAIL, character.style ), bounds );
     }
+    return width;
+}
+
+
+// Number of characters of a line starting at pos that are within the grid.
+static usize clip_line( screenpos const pos, usize const n )
+{
+    screensize const gridSize = s_screenInfo.screen.size;
+    if ( pos.x < 1 || pos.y < 1 || pos.x > gridSize.w || pos.y > gridSize.h ) return 0;
+
+    return min( n, (usize)( gridSize.w - pos.x + 1 ) );
+}
+
+
+// Same as clip_line() for the height of an area.
+static usize clip_height( screenpos const ul, usize const height )
+{
+    screensize const gridSize = s_screenInfo.screen.size;
+    if ( ul.y < 1 || ul.y > gridSize.h ) return 0;
+
+    return min( height, (usize)( gridSize.h - ul.y + 1 ) );
+}
+
+
+int term_write( utf16 const *format, ... )
+{
+    static utf16 buffer[TERM_WRITE_BUFFER_SIZE] = {};
 
+    va_list args;
+	va_start( args, format );
+    int const bufferSize = vsnwprintf( buffer, ARR_COUNT( buffer ), format, args );
+	va_end( args );
+
+    assert( bufferSize > 0 ); // Otherwise, we may have busted the limit of the buffer, or a bad format has been given.
+
+    term_put_run( cursor_pos(), style_current(), buffer, bufferSize );
     return bufferSize;
 }
 
 
-void term_clear( void )
+usize term_put_run( screenpos const pos, struct Style const style, utf16 const *text, usize const n )
 {
-    for ( usize idx = 0; idx < ARR_COUNT( s_screenInfo.screen.raw ); ++idx )
+    // We don't want to continue on the next line when reaching the end of the screen, the rest is dropped.
+    usize const maxCount = clip_line( pos, n );
+    usize count = 0;
+    if ( maxCount > 0 )
     {
-        s_screenInfo.screen.raw[idx] = character_default();
+        struct ChangedBounds bounds = no_bounds();
+        struct Character *const row = s_screenInfo.screen.rows[pos.y - 1];
+        usize const y = pos.y - 1;
+        for ( usize idx = 0; idx < n && count < maxCount; )
+        {
+            termglyph glyph;
+            idx += glyph_decode( text + idx, n - idx, &glyph );
+            count += put_glyph( row, pos.x - 1 + count, y, character_make( glyph, style ), &bounds );
+        }
+        damage_bounds( bounds );
     }
+
+    cursor_update_pos( SCREENPOS( pos.x + count, pos.y ) );
+    return count;
 }
 
 
-void term_refresh( void )
+void term_fill( screenpos const ul, vec2u16 const size, struct Character const character )
 {
-    static utf16 buffer[TERM_REFRESH_BUFFER_SIZE] = {};
-    usize const bufTotalSize = ARR_COUNT( buffer );
-    usize bufPos = 0;
+    assert( !character_needs_refresh( character ) );
 
-    screensize const gameSize = s_screenInfo.supportedGameSize;
-    struct Style style = STYLE_DEFAULT;
-    screenpos cursorPos = (screenpos) { .y = 1, .x = 1 };
+    usize const width = clip_line( ul, size.w );
+    usize const height = clip_height( ul, size.h );
+    if ( width == 0 ) return;
 
-    for ( usize y = 0; y < gameSize.h; ++y )
+    struct ChangedBounds bounds = no_bounds();
+    for ( usize y = 0; y < height; ++y )
     {
-        for ( usize x = 0; x < gameSize.w; ++x )
+        struct Character *const row = s_screenInfo.screen.rows[ul.y - 1 + y];
+        for ( usize x = 0; x < width; )
         {
-            struct Character *character = &s_screenInfo.screen.content[y][x];
+            x += put_glyph( row, ul.x - 1 + x, ul.y - 1 + y, character, &bounds );
+        }
+    }
+    damage_bounds( bounds );
+}
 
-            if ( !character_needs_refresh( *character ) )
-                continue;
 
-            // Ensure first that the cursor is in good position. If not, update it accordingly.
-            screenpos const targetPos = (screenpos) { .y = y + 1, .x = x + 1 };
-            if ( cursorPos.raw != targetPos.raw )
-            {
-                bufPos += term_sequence_set_cursor_pos( buffer + bufPos, bufTotalSize - bufPos, targetPos );
-                cursorPos = targetPos;
-            }
+void term_blit( screenpos const ul, vec2u16 const size, struct Character const *characters )
+{
+    usize const width = clip_line( ul, size.w );
+    usize const height = clip_height( ul, size.h );
+    if ( width == 0 ) return;
 
-            // Then check if the style needs to be adjusted before writing the unicode character
-            if ( !style_equals( style, character->style ) )
+    struct ChangedBounds bounds = no_bounds();
+    for ( usize y = 0; y < height; ++y )
+    {
+        struct Character *const row = s_screenInfo.screen.rows[ul.y - 1 + y];
+        struct Character const *src = &characters[y * size.w];
+        for ( usize x = 0; x < width; )
+        {
+            assert( !character_needs_refresh( src[x] ) );
+            // The second half of a wide glyph is written along with the first one.
+            if ( src[x].glyph == GLYPH_WIDE_TAIL )
             {
-                bufPos += term_sequence_set_style( buffer + bufPos, bufTotalSize - bufPos, character->style );
-                style = character->style;
+                x += 1;
+                continue;
             }
+            x += put_glyph( row, ul.x - 1 + x, ul.y - 1 + y, src[x], &bounds );
+        }
+    }
+    damage_bounds( bounds );
+}
 
-            // Write the new unicode character
-            bufPos += snwprintf( buffer + bufPos, bufTotalSize - bufPos, L"%lc", character->unicode );
-            cursorPos.x += 1;
 
-            character_refreshed( character );
+void term_invalidate_area( screenpos const ul, vec2u16 const size )
+{
+    usize const width = clip_line( ul, size.w );
+    usize const height = clip_height( ul, size.h );
+
+    for ( usize y = 0; y < height; ++y )
+    {
+        struct Character *const row = get_character_at_pos( SCREENPOS( ul.x, ul.y + y ) );
+        for ( usize x = 0; x < width; ++x )
+        {
+            character_mark_as_refresh_needed( &row[x] );
         }
     }
+    if ( height > 0 ) add_damage( ul.x - 1, ul.y - 1, width, height );
+}
+
 
-    if ( bufPos > 0 )
+void term_clear( void )
+{
+    usize const area = (usize)s_screenInfo.screen.size.w * s_screenInfo.screen.size.h;
+    for ( usize idx = 0; idx < area; ++idx )
     {
-        bufPos += term_sequence_reset_cursor_pos( buffer + bufPos, bufTotalSize - bufPos );
-        bufPos += term_sequence_reset_style( buffer + bufPos, bufTotalSize - bufPos );
+        s_screenInfo.screen.cells[idx] = character_default();
+    }
+    memset( s_screenInfo.screen.clearedSpans, 0, s_screenInfo.screen.size.h * sizeof( struct ClearedSpan ) );
+    memset( s_screenInfo.screen.damage, 0, s_screenInfo.screen.size.h * sizeof( struct DamagedRow ) );
+}
+
 
-        wprintf( buffer );
+// Copies the lines of the area in the scratch buffer, indexed like the grid.
+static struct Character const *save_lines( usize const top, usize const height )
+{
+    struct Screen *const screen = &s_screenInfo.screen;
+    for ( usize y = top; y < top + height; ++y )
+    {
+        resolve_cleared_span( y );
+        memcpy( &screen->scratch[y * screen->size.w], screen->rows[y], screen->size.w * sizeof( struct Character ) );
     }
+    return screen->scratch;
 }
 
 
-void term_on_resize( screensize const newSize )
+// Shifts only the content of the area in the buffer. The terminal doesn't move anything, so every character
+// that differs from what is already displayed needs to be written again.
+static void scroll_buffer_area( screenpos const ul, vec2u16 const size, enum ScrollDirection const direction, u16 const nbLines )
 {
-    screensize const old = s_screenInfo.size;
-    if ( old.w == newSize.w && old.h == newSize.h ) return;
+    usize const top = ul.y - 1;
+    usize const left = ul.x - 1;
+    usize const width = s_screenInfo.screen.size.w;
+    struct Character const *old = save_lines( top, size.h );
 
-    if ( old.h > newSize.h && newSize.h < GAME_SIZE_HEIGHT )
+    for ( usize y = top; y < top + size.h; ++y )
     {
-        for ( usize lineHeight = newSize.h; lineHeight < old.h; lineHeight++ )
+        usize const srcY = ( direction == ScrollDirection_UP ) ? y + nbLines : y - nbLines;
+        bool const exposed = srcY < top || srcY >= top + size.h;
+
+        for ( usize x = left; x < left + size.w; ++x )
         {
-            for ( usize x = 0; x < GAME_SIZE_WIDTH; ++x )
+            struct Character const displayed = old[y * width + x];
+            struct Character const newC = exposed ? character_default() : old[srcY * width + x];
+            struct Character *const current = &s_screenInfo.screen.rows[y][x];
+
+            *current = newC;
+            character_refreshed( current );
+            if ( character_needs_refresh( displayed ) || !character_equals( displayed, newC ) )
             {
-                struct Character *character = get_character_at_pos( SCREENPOS( x + 1, lineHeight + 1 ) );
-                character_mark_as_refresh_needed( character );
+                character_mark_as_refresh_needed( current );
             }
         }
     }
+}
+
+
+// When the area covers entire lines, the rows are only rotated and the exposed ones cleared.
+static void rotate_buffer_lines( usize const top, usize const height, enum ScrollDirection const direction, u16 const nbLines )
+{
+    struct Character **const rows = &s_screenInfo.screen.rows[top];
+    struct Character *moved[nbLines];
 
-    if ( old.w > newSize.w && newSize.w < GAME_SIZE_WIDTH )
+    if ( direction == ScrollDirection_UP )
     {
-        for ( usize lineHeight = 0; lineHeight < GAME_SIZE_HEIGHT; lineHeight++ )
-        {
-            for ( usize x = newSize.w; x < old.w; ++x )
-            {
-                struct Character *character = get_character_at_pos( SCREENPOS( x + 1, lineHeight + 1 ) );
-                character_mark_as_refresh_needed( character );
-            }
-        }
+        memcpy( moved, rows, nbLines * sizeof( struct Character * ) );
+        memmove( rows, rows + nbLines, ( height - nbLines ) * sizeof( struct Character * ) );
+        memcpy( rows + height - nbLines, moved, nbLines * sizeof( struct Character * ) );
+    }
+    else
+    {
+        memcpy( moved, rows + height - nbLines, nbLines * sizeof( struct Character * ) );
+        memmove( rows + nbLines, rows, ( height - nbLines ) * sizeof( struct Character * ) );
+        memcpy( rows, moved, nbLines * sizeof( struct Character * ) );
     }
 
-    s_screenInfo.size = newSize;
-    s_screenInfo.supportedGameSize = game_size_from_screen( newSize );
-
-    struct Event screenResized = (struct Event) {
-        .type = EventType_SCREEN_RESIZED,
-        .screenResized = (struct EventScreenResized) {
-            .size = s_screenInfo.size
+    for ( usize idx = 0; idx < nbLines; ++idx )
+    {
+        struct Character *const row = moved[idx];
+        for ( usize x = 0; x < s_screenInfo.screen.size.w; ++x )
+        {
+            row[x] = character_default();
         }
-    };
-    event_trigger( &screenResized );
-//    components_on_screen_resize( s_screenInfo.size );
+    }
 }
 
 
-struct Character term_character_buffered_at_pos( screenpos const pos )
+// The terminal shifts entire lines, so the lines of the area are shifted in the buffer as well.
+// Inside the area, the characters move along with what the terminal displays.
+// Outside of it, the content of the buffer stays in place and is written again only if the terminal now shows
+// something else there.
+static void scroll_buffer_lines( screenpos const ul, vec2u16 const size, enum ScrollDirection const direction, u16 const nbLines )
 {
-    return s_screenInfo.screen.content[pos.y - 1][pos.x - 1];
-}
+    usize const top = ul.y - 1;
+    usize const left = ul.x - 1;
+    usize const right = left + size.w;
+    usize const width = s_screenInfo.screen.size.w;
 
+    if ( left == 0 && right >= width )
+    {
+        for ( usize y = top; y < top + size.h; ++y ) resolve_cleared_span( y );
+        rotate_buffer_lines( top, size.h, direction, nbLines );
+        return;
+    }
 
-screensize term_size( void )
+    struct Character const *old = save_lines( top, size.h );
+
+    for ( usize y = top; y < top + size.h; ++y )
+    {
+        usize const srcY = ( direction == ScrollDirection_UP ) ? y + nbLines : y - nbLines;
+        bool const exposed = srcY < top || srcY >= top + size.h;
+
+        for ( usize x = 0; x < width; ++x )
+        {
+            struct Character *const current = &s_screenInfo.screen.rows[y][x];
+
+            if ( x >= left && x < right )
+            {
+                // A scroll clears the new lines with the default style, as it is always sent at the start of a frame.
+                *current = exposed ? character_default() : old[srcY * width + x];
+                continue;
+            }
+
+            struct Character const displayed = exposed ? character_default() : old[srcY * width + x];
+            *current = old[y * width + x];
+            character_refreshed( current );
+
+            if ( character_needs_refresh( displayed ) || !character_equals( displayed, *current ) )
+            {
+                character_mark_as_refresh_needed( current );
+            }
+        }
+    }
+}
+
+
+// The refresh flags moved along with the content. Damages each run of characters needing a refresh in the area.
+static void damage_characters_to_refresh( usize const top, usize const height, usize const left, usize const right )
+{
+    for ( usize y = top; y < top + height; ++y )
+    {
+        struct Character const *row = s_screenInfo.screen.rows[y];
+        usize x = left;
+        while ( x < right )
+        {
+            if ( !character_needs_refresh( row[x] ) )
+            {
+                ++x;
+                continue;
+            }
+
+            usize const begin = x;
+            while ( x < right && character_needs_refresh( row[x] ) ) ++x;
+            add_damage( begin, y, x - begin, 1 );
+        }
+    }
+}
+
+
+void term_scroll( screenpos const ul, vec2u16 const size, enum ScrollDirection const direction, u16 const nbLines )
+{
+    if ( nbLines == 0 || size.w == 0 || size.h == 0 ) return;
+
+    screensize const gridSize = s_screenInfo.screen.size;
+    u16 const bottom = ul.y + size.h - 1;
+    u16 const right = ul.x + size.w - 1;
+    if ( ul.x < 1 || ul.y < 1 || right > gridSize.w || bottom > gridSize.h ) return;
+
+    // The terminal shifts whole lines, including what is past the grid. Only do it when the grid covers them.
+    bool const hardwareScroll = nbLines < size.h
+        && s_screenInfo.nbScrolls < TERM_MAX_SCROLLS_PER_FRAME
+        && bottom <= s_screenInfo.size.h
+        && s_screenInfo.size.w <= gridSize.w;
+
+    if ( !hardwareScroll )
+    {
+        scroll_buffer_area( ul, size, direction, min( nbLines, size.h ) );
+        damage_characters_to_refresh( ul.y - 1, size.h, ul.x - 1, ul.x - 1 + size.w );
+        return;
+    }
+
+    scroll_buffer_lines( ul, size, direction, nbLines );
+    damage_characters_to_refresh( ul.y - 1, size.h, 0, gridSize.w );
+    term_layers_on_scroll( ul.y, bottom, direction, nbLines );
+    s_screenInfo.scrolls[s_screenInfo.nbScrolls++] = (struct ScrollRequest) {
+        .top = ul.y,
+        .bottom = bottom,
+        .direction = direction,
+        .nbLines = nbLines
+    };
+}
+
+
+// Must be written before any character of the frame, as the characters have been written in the buffer
+// with the shifted content in mind.
+static usize write_scroll_requests( utf16 *const buffer, usize const bufferSize )
+{
+    if ( s_screenInfo.nbScrolls == 0 ) return 0;
+
+    usize bufPos = 0;
+    for ( usize idx = 0; idx < s_screenInfo.nbScrolls; ++idx )
+    {
+        struct ScrollRequest const *scroll = &s_screenInfo.scrolls[idx];
+        bufPos += term_sequence_set_scroll_region( buffer + bufPos, bufferSize - bufPos, scroll->top, scroll->bottom );
+
+        if ( scroll->direction == ScrollDirection_UP )
+            bufPos += term_sequence_scroll_up( buffer + bufPos, bufferSize - bufPos, scroll->nbLines );
+        else
+            bufPos += term_sequence_scroll_down( buffer + bufPos, bufferSize - bufPos, scroll->nbLines );
+    }
+
+    // Resetting the margins moves the cursor back to 1:1, where the frame expects it to be.
+    bufPos += term_sequence_reset_scroll_region( buffer + bufPos, bufferSize - bufPos );
+    s_screenInfo.nbScrolls = 0;
+
+    return bufPos;
+}
+
+
+// The frame the writer is done with becomes the one to build next.
+static void submit_frame( usize const size )
+{
+    term_writer_submit( s_screenInfo.frame, size );
+    s_screenInfo.nbFramesSent += 1;
+
+    utf16 *const frame = s_screenInfo.frame;
+    usize const capacity = s_screenInfo.frameCapacity;
+    s_screenInfo.frame = s_screenInfo.frontFrame;
+    s_screenInfo.frameCapacity = s_screenInfo.frontFrameCapacity;
+    s_screenInfo.frontFrame = frame;
+    s_screenInfo.frontFrameCapacity = capacity;
+
+    s_screenInfo.nbDroppedBeforeLastFrame = s_screenInfo.nbDroppedFrames;
+    s_screenInfo.nbDroppedFrames = 0;
+}
+
+
+static void update_link_monitor( bool const writerBehind )
+{
+    struct LinkMonitor *const link = &s_screenInfo.link;
+
+    usize const nbFramesWritten = s_screenInfo.output.async ? term_writer_nb_frames_written() : s_screenInfo.nbFramesWritten;
+    bool const newMeasure = nbFramesWritten != link->nbFramesWrittenSeen;
+    link->nbFramesWrittenSeen = nbFramesWritten;
+
+    bool const slowWrite = newMeasure && term_last_frame_stats().writeDuration > time_msec_to_nsec( TERM_LINK_SLOW_WRITE_MSEC );
+    if ( writerBehind || slowWrite )
+    {
+        link->nbCongestedRefreshes += 1;
+        link->nbClearRefreshes = 0;
+    }
+    else
+    {
+        link->nbClearRefreshes += 1;
+        link->nbCongestedRefreshes = 0;
+    }
+
+    // Different thresholds to enter and leave the mode, so that it doesn't flip on every hiccup.
+    if ( !link->saturated && link->nbCongestedRefreshes >= TERM_LINK_SATURATION_THRESHOLD )
+    {
+        link->saturated = true;
+    }
+    else if ( link->saturated && link->nbClearRefreshes >= TERM_LINK_RECOVERY_THRESHOLD )
+    {
+        link->saturated = false;
+    }
+}
+
+
+static bool is_in_cosmetic_area( usize const x, usize const y )
+{
+    for ( usize idx = 0; idx < s_screenInfo.nbCosmeticAreas; ++idx )
+    {
+        struct CosmeticArea const *area = &s_screenInfo.cosmeticAreas[idx];
+        usize const left = area->ul.x - 1;
+        usize const top = area->ul.y - 1;
+
+        if ( x >= left && x < left + area->size.w && y >= top && y < top + area->size.h ) return true;
+    }
+    return false;
+}
+
+
+static void write_frame( utf16 const *frame, usize const size )
+{
+    nsecond const writeBegin = time_get_timestamp_nsec();
+    s_screenInfo.lastFrameStats = s_screenInfo.output.outputCb( frame, size );
+    nsecond const writeEnd = time_get_timestamp_nsec();
+    s_screenInfo.lastFrameStats.writeDuration = writeEnd - writeBegin;
+    s_screenInfo.writeEnds[s_screenInfo.nbFramesWritten % TERM_WRITE_TIMES_HISTORY] = writeEnd;
+    s_screenInfo.nbFramesWritten += 1;
+    s_screenInfo.nbFramesSent += 1;
+}
+
+
+static struct Character composited_at( usize const x, usize const y )
+{
+    struct Character character = s_screenInfo.screen.rows[y][x];
+    term_layers_character_at( SCREENPOS( x + 1, y + 1 ), &character );
+    return character;
+}
+
+
+// What the terminal is expected to display at x:y. A layer, a scrolled area or the screen width can cut a wide
+// glyph: the remaining half is shown as blank. The second half of a wide glyph always has the style of the first one.
+static struct Character displayed_at( usize const x, usize const y, usize const visibleWidth )
+{
+    struct Character character = composited_at( x, y );
+    if ( character.glyph == GLYPH_WIDE_TAIL )
+    {
+        struct Character const lead = ( x > 0 ) ? composited_at( x - 1, y ) : character_default();
+        if ( glyph_width( lead.glyph ) == 1 ) character.glyph = L' ';
+        else character.style = lead.style;
+    }
+    else if ( glyph_width( character.glyph ) > 1 )
+    {
+        if ( x + 1 >= visibleWidth || composited_at( x + 1, y ).glyph != GLYPH_WIDE_TAIL ) character.glyph = L' ';
+    }
+    return character;
+}
+
+
+// Lines of a frame that are encoded on their own, possibly on another thread.
+// The first band is encoded in place, in the frame. The next ones are encoded in their own buffer and can't know
+// the style the previous band ends with: the style of their first character is left out, and written when the band
+// is appended to the frame. The cursor is always positioned for the first character of a band, as the previous
+// band ended on another line. The frame is then the same as if all the lines had been encoded in a row.
+struct FrameBand
+{
+    usize top;
+    usize bottom; // Excluded
+    screensize visibleSize;
+    bool deferCosmetic;
+    bool isFirst;
+
+    utf16 **buffer;
+    usize *capacity;
+    usize begin;
+    usize end;
+
+    bool hasContent;
+    usize firstStylePos; // Where the style of the first character belongs, for the bands after the first one.
+    struct Style firstStyle;
+    struct Style lastStyle;
+    screenpos cursorPos;
+};
+
+
+// The band must have room for it. Its end, style and cursor are updated accordingly.
+static void encode_character( struct FrameBand *const band, usize const x, usize const y, struct Character const output )
+{
+    utf16 *const buffer = *band->buffer;
+    usize const bufTotalSize = *band->capacity;
+    screenpos const targetPos = (screenpos) { .y = y + 1, .x = x + 1 };
+
+    // Ensure first that the cursor is in good position. If not, update it accordingly.
+    if ( band->cursorPos.raw != targetPos.raw )
+    {
+        band->end += term_sequence_set_cursor_pos( buffer + band->end, bufTotalSize - band->end, targetPos );
+        band->cursorPos = targetPos;
+    }
+
+    // Then check if the style needs to be adjusted before writing the glyph
+    if ( !band->isFirst && !band->hasContent )
+    {
+        band->firstStylePos = band->end;
+        band->firstStyle = output.style;
+        band->lastStyle = output.style;
+    }
+    else if ( !style_equals( band->lastStyle, output.style ) )
+    {
+        band->end += term_sequence_set_style_delta( buffer + band->end, bufTotalSize - band->end, band->lastStyle, output.style );
+        band->lastStyle = output.style;
+    }
+
+    // Write the glyph, already encoded
+    band->end += glyph_encode( output.glyph, buffer + band->end );
+    band->cursorPos.x += glyph_width( output.glyph );
+    band->hasContent = true;
+}
+
+
+static void encode_band( struct FrameBand *const band )
+{
+    band->end = band->begin;
+    band->lastStyle = STYLE_DEFAULT;
+    // The frame starts with the cursor at 1:1. The next bands start with a position no character can have.
+    band->cursorPos = band->isFirst ? SCREENPOS( 1, 1 ) : (screenpos) {};
+    usize const visibleWidth = band->visibleSize.w;
+    bool bandFull = false;
+
+    for ( usize y = band->top; y < band->bottom && !bandFull; ++y )
+    {
+        // Only the damaged spans are visited. What isn't sent with this frame is damaged again for the next one.
+        struct DamagedRow *const damagedRow = &s_screenInfo.screen.damage[y];
+        struct DamagedRow const damage = *damagedRow;
+        damagedRow->nbSpans = 0;
+
+        struct Character *const row = s_screenInfo.screen.rows[y];
+
+        for ( usize spanIdx = 0; spanIdx < damage.nbSpans && !bandFull; ++spanIdx )
+        {
+            usize const spanEnd = min( (usize)damage.spans[spanIdx].end, visibleWidth );
+
+            for ( usize x = damage.spans[spanIdx].begin; x < spanEnd; ++x )
+            {
+                struct Character *character = &row[x];
+
+                if ( !character_needs_refresh( *character ) )
+                    continue;
+
+                if ( band->deferCosmetic && is_in_cosmetic_area( x, y ) )
+                {
+                    damage_row( damagedRow, x, x + 1 );
+                    continue;
+                }
+
+                // Already written along with a character before it: the second half of a wide glyph, or what is left
+                // of one after its first half was overwritten.
+                if ( band->cursorPos.y == y + 1 && band->cursorPos.x > x + 1 )
+                {
+                    character_refreshed( character );
+                    continue;
+                }
+
+                // What is left will be sent with the next frame.
+                if ( !reserve_buffer( band->buffer, band->capacity, band->end + TERM_REFRESH_CHARACTER_MAX_SIZE + TERM_REFRESH_FOOTER_MAX_SIZE ) )
+                {
+                    damage_row( damagedRow, x, damage.spans[spanIdx].end );
+                    for ( usize idx = spanIdx + 1; idx < damage.nbSpans; ++idx )
+                    {
+                        damage_row( damagedRow, damage.spans[idx].begin, damage.spans[idx].end );
+                    }
+                    bandFull = true;
+                    break;
+                }
+
+                // The second half of a wide glyph is written through the first one.
+                usize outputX = x;
+                struct Character output = displayed_at( x, y, visibleWidth );
+                if ( output.glyph == GLYPH_WIDE_TAIL )
+                {
+                    outputX = x - 1;
+                    output = displayed_at( outputX, y, visibleWidth );
+                }
+                encode_character( band, outputX, y, output );
+
+                // Overwriting the first half of a wide glyph leaves its second half blank on the terminal, but not
+                // necessarily with the style we expect.
+                for ( usize next = outputX + glyph_width( output.glyph ); next < visibleWidth && row[next].glyph == GLYPH_WIDE_TAIL; ++next )
+                {
+                    struct Character const nextOutput = displayed_at( next, y, visibleWidth );
+                    if ( nextOutput.glyph == GLYPH_WIDE_TAIL ) break;
+
+                    if ( !reserve_buffer( band->buffer, band->capacity, band->end + TERM_REFRESH_CHARACTER_MAX_SIZE + TERM_REFRESH_FOOTER_MAX_SIZE ) )
+                    {
+                        character_mark_as_refresh_needed( &row[next] );
+                        damage_row( damagedRow, next, next + 1 );
+                        break;
+                    }
+                    encode_character( band, next, y, nextOutput );
+                }
+
+                character_refreshed( character );
+            }
+        }
+    }
+}
+
+
+static void encode_band_job( void *const context, usize const jobIdx )
+{
+    TRACE_BEGIN( "encode_band" );
+    encode_band( &( (struct FrameBand *)context )[jobIdx] );
+    TRACE_END();
+}
+
+
+static usize damaged_width( usize const y, usize const visibleWidth )
+{
+    struct DamagedRow const *damage = &s_screenInfo.screen.damage[y];
+
+    usize width = 0;
+    for ( usize idx = 0; idx < damage->nbSpans && damage->spans[idx].begin < visibleWidth; ++idx )
+    {
+        width += min( (usize)damage->spans[idx].end, visibleWidth ) - damage->spans[idx].begin;
+    }
+    return width;
+}
+
+
+// One band per encoding thread when there is enough to encode, with about as many damaged characters in each.
+// Returns the number of bands.
+static usize split_in_bands( struct FrameBand *const bands, screensize const visibleSize )
+{
+    usize const maxBands = term_workers_count() + 1;
+    bands[0] = (struct FrameBand) { .top = 0, .bottom = visibleSize.h };
+    if ( maxBands == 1 ) return 1;
+
+    usize total = 0;
+    for ( usize y = 0; y < visibleSize.h; ++y )
+    {
+        total += damaged_width( y, visibleSize.w );
+    }
+    if ( total < TERM_PARALLEL_ENCODE_MIN_CHARACTERS ) return 1;
+
+    usize nbBands = 0;
+    usize top = 0;
+    usize damaged = 0;
+    for ( usize y = 0; y < visibleSize.h && nbBands < maxBands - 1; ++y )
+    {
+        damaged += damaged_width( y, visibleSize.w );
+        if ( damaged * maxBands >= total * ( nbBands + 1 ) )
+        {
+            bands[nbBands++] = (struct FrameBand) { .top = top, .bottom = y + 1 };
+            top = y + 1;
+        }
+    }
+    bands[nbBands++] = (struct FrameBand) { .top = top, .bottom = visibleSize.h };
+
+    return nbBands;
+}
+
+
+// Every character of the lines will be sent again, as the terminal didn't receive them.
+static void invalidate_lines( usize const top, usize const bottom )
+{
+    if ( bottom > top )
+    {
+        term_invalidate_area( SCREENPOS( 1, top + 1 ), VEC2U16( s_screenInfo.screen.size.w, bottom - top ) );
+    }
+}
+
+
+// Copies the band at the end of the frame, along with the style its first character needs.
+static usize append_band( struct FrameBand const *band, usize bufPos, struct Style *const inOutStyle )
+{
+    if ( !band->hasContent ) return bufPos;
+
+    usize const size = band->end - band->begin;
+    if ( !reserve_frame( bufPos + size + TERM_REFRESH_CHARACTER_MAX_SIZE + TERM_REFRESH_FOOTER_MAX_SIZE ) )
+    {
+        invalidate_lines( band->top, band->bottom );
+        return bufPos;
+    }
+
+    utf16 const *bandFrame = *band->buffer;
+    utf16 *const buffer = s_screenInfo.frame;
+    usize const bufTotalSize = s_screenInfo.frameCapacity;
+
+    memcpy( buffer + bufPos, bandFrame, band->firstStylePos * sizeof( utf16 ) );
+    bufPos += band->firstStylePos;
+
+    if ( !style_equals( *inOutStyle, band->firstStyle ) )
+    {
+        bufPos += term_sequence_set_style_delta( buffer + bufPos, bufTotalSize - bufPos, *inOutStyle, band->firstStyle );
+    }
+
+    usize const rest = band->end - band->firstStylePos;
+    memcpy( buffer + bufPos, bandFrame + band->firstStylePos, rest * sizeof( utf16 ) );
+    bufPos += rest;
+
+    *inOutStyle = band->lastStyle;
+    return bufPos;
+}
+
+
+void term_refresh( void )
+{
+    bool const writerBehind = s_screenInfo.output.async && term_writer_is_behind();
+    update_link_monitor( writerBehind );
+
+    // Nothing is queued behind a waiting frame. The changes stay in the buffer and the first frame built once the
+    // writer caught up contains all of them, based on what the terminal will display by then.
+    if ( writerBehind )
+    {
+        s_screenInfo.nbDroppedFrames += 1;
+        return;
+    }
+
+    // Cosmetic changes stay in the buffer as well, and are merged into a later frame.
+    bool const deferCosmetic = s_screenInfo.link.saturated && ( s_screenInfo.link.nbFramesBuilt % TERM_COSMETIC_FRAME_INTERVAL ) != 0;
+    s_screenInfo.link.nbFramesBuilt += 1;
+
+    // The back frame is allocated on the first refresh after a swap.
+    if ( !reserve_frame( TERM_REFRESH_BUFFER_SIZE ) ) return;
+
+    // Keep room for the synchronized update header, only written if the frame isn't empty.
+    usize const headerSize = s_screenInfo.output.synchronizedUpdate ? term_sequence_begin_synchronized_update( s_screenInfo.frame, s_screenInfo.frameCapacity ) : 0;
+    usize bufPos = headerSize;
+
+    bufPos += write_scroll_requests( s_screenInfo.frame + bufPos, s_screenInfo.frameCapacity - bufPos );
+
+    screensize const visibleSize = visible_size();
+
+    // Resolved beforehand, as the bands can only modify their own lines.
+    for ( usize y = 0; y < visibleSize.h; ++y )
+    {
+        resolve_cleared_span( y );
+    }
+
+    struct FrameBand bands[TERM_MAX_ENCODERS];
+    usize const nbBands = split_in_bands( bands, visibleSize );
+    for ( usize idx = 0; idx < nbBands; ++idx )
+    {
+        bands[idx].visibleSize = visibleSize;
+        bands[idx].deferCosmetic = deferCosmetic;
+        bands[idx].isFirst = ( idx == 0 );
+        bands[idx].buffer = ( idx == 0 ) ? &s_screenInfo.frame : &s_screenInfo.bandFrames[idx];
+        bands[idx].capacity = ( idx == 0 ) ? &s_screenInfo.frameCapacity : &s_screenInfo.bandFrameCapacities[idx];
+        bands[idx].begin = ( idx == 0 ) ? bufPos : 0;
+    }
+    term_workers_run( encode_band_job, bands, nbBands );
+
+    bufPos = bands[0].end;
+    struct Style style = bands[0].lastStyle;
+    for ( usize idx = 1; idx < nbBands; ++idx )
+    {
+        bufPos = append_band( &bands[idx], bufPos, &style );
+    }
+
+    if ( bufPos > headerSize )
+    {
+        utf16 *const buffer = s_screenInfo.frame;
+        usize const bufTotalSize = s_screenInfo.frameCapacity;
+
+        bufPos += term_sequence_reset_cursor_pos( buffer + bufPos, bufTotalSize - bufPos );
+        if ( !style_equals( style, STYLE_DEFAULT ) )
+        {
+            bufPos += term_sequence_reset_style( buffer + bufPos, bufTotalSize - bufPos );
+        }
+        if ( s_screenInfo.output.synchronizedUpdate )
+        {
+            bufPos += term_sequence_end_synchronized_update( buffer + bufPos, bufTotalSize - bufPos );
+        }
+
+        if ( s_screenInfo.output.async )
+        {
+            submit_frame( bufPos );
+        }
+        else
+        {
+            write_frame( buffer, bufPos );
+        }
+    }
+}
+
+
+// Reallocates the grid once, keeping the content that still fits in it.
+static bool resize_grid( screensize const size )
+{
+    struct Screen newScreen;
+    if ( !screen_alloc( &newScreen, size ) )
+    {
+        fprintf( stderr, "[ERROR]: Failed to resize the screen to %ux%u.\n", size.w, size.h );
+        return false;
+    }
+
+    struct Screen *const oldScreen = &s_screenInfo.screen;
+    usize const height = min( oldScreen->size.h, size.h );
+    usize const width = min( oldScreen->size.w, size.w );
+
+    for ( usize y = 0; y < height; ++y )
+    {
+        resolve_cleared_span( y );
+        memcpy( newScreen.rows[y], oldScreen->rows[y], width * sizeof( struct Character ) );
+
+        struct DamagedRow const *damage = &oldScreen->damage[y];
+        for ( usize idx = 0; idx < damage->nbSpans && damage->spans[idx].begin < width; ++idx )
+        {
+            damage_row( &newScreen.damage[y], damage->spans[idx].begin, min( (usize)damage->spans[idx].end, width ) );
+        }
+    }
+
+    screen_free( oldScreen );
+    *oldScreen = newScreen;
+    return true;
+}
+
+
+void term_on_resize( screensize const newSize )
+{
+    screensize const old = s_screenInfo.size;
+    if ( old.w == newSize.w && old.h == newSize.h ) return;
+
+    screensize const oldVisibleSize = visible_size();
+    screensize const gridSize = grid_size_from_screen( newSize );
+    if ( gridSize.w != s_screenInfo.screen.size.w || gridSize.h != s_screenInfo.screen.size.h )
+    {
+        resize_grid( gridSize );
+    }
+
+    s_screenInfo.size = newSize;
+
+    // Only what wasn't displayed before needs to be invalidated, the rest is still on the terminal.
+    screensize const newVisibleSize = visible_size();
+    for ( usize y = 0; y < newVisibleSize.h; ++y )
+    {
+        u16 const begin = ( y < oldVisibleSize.h ) ? oldVisibleSize.w : 0;
+        set_cleared_span( y, begin, newVisibleSize.w );
+    }
+    term_layers_on_resize();
+
+    struct Event screenResized = (struct Event) {
+        .type = EventType_SCREEN_RESIZED,
+        .screenResized = (struct EventScreenResized) {
+            .size = s_screenInfo.size
+        }
+    };
+    event_trigger( &screenResized );
+//    components_on_screen_resize( s_screenInfo.size );
+}
+
+
+void term_add_cosmetic_area( screenpos const ul, vec2u16 const size )
+{
+    assert( s_screenInfo.nbCosmeticAreas < TERM_MAX_COSMETIC_AREAS );
+    if ( s_screenInfo.nbCosmeticAreas == TERM_MAX_COSMETIC_AREAS ) return;
+
+    s_screenInfo.cosmeticAreas[s_screenInfo.nbCosmeticAreas++] = (struct CosmeticArea) { .ul = ul, .size = size };
+}
+
+
+void term_remove_cosmetic_area( screenpos const ul, vec2u16 const size )
+{
+    for ( usize idx = 0; idx < s_screenInfo.nbCosmeticAreas; ++idx )
+    {
+        struct CosmeticArea const *area = &s_screenInfo.cosmeticAreas[idx];
+        if ( area->ul.raw != ul.raw || area->size.w != size.w || area->size.h != size.h ) continue;
+
+        s_screenInfo.cosmeticAreas[idx] = s_screenInfo.cosmeticAreas[--s_screenInfo.nbCosmeticAreas];
+        return;
+    }
+}
+
+
+u8 term_damage_set_owner( u8 const owner )
+{
+    assert( owner < TERM_MAX_DAMAGE_OWNERS );
+
+    u8 const previous = s_screenInfo.damageOwner;
+    s_screenInfo.damageOwner = owner;
+    return previous;
+}
+
+
+struct TermDamageTotals term_damage_totals( u8 const owner )
+{
+    assert( owner < TERM_MAX_DAMAGE_OWNERS );
+    return s_screenInfo.damageTotals[owner];
+}
+
+
+void term_damage_reset_totals( void )
+{
+    memset( s_screenInfo.damageTotals, 0, sizeof( s_screenInfo.damageTotals ) );
+}
+
+
+struct Character term_character_buffered_at_pos( screenpos const pos )
+{
+    return *get_character_at_pos( pos );
+}
+
+
+struct Character term_character_composited_at_pos( screenpos const pos )
+{
+    struct Character const buffered = *get_character_at_pos( pos );
+    struct Character displayed = displayed_at( pos.x - 1, pos.y - 1, visible_size().w );
+
+    if ( character_needs_refresh( buffered ) ) character_mark_as_refresh_needed( &displayed );
+    return displayed;
+}
+
+
+screensize term_size( void )
 {
     return s_screenInfo.size;
 }
+
+
+bool term_is_link_saturated( void )
+{
+    return s_screenInfo.link.saturated;
+}
+
+
+bool term_has_pending_changes( void )
+{
+    if ( s_screenInfo.nbScrolls > 0 ) return true;
+
+    // The lines out of the terminal are only refreshed once it grows again.
+    screensize const visibleSize = visible_size();
+    for ( usize y = 0; y < visibleSize.h; ++y )
+    {
+        if ( s_screenInfo.screen.damage[y].nbSpans > 0 ) return true;
+    }
+    return false;
+}
+
+
+usize term_nb_frames_sent( void )
+{
+    return s_screenInfo.nbFramesSent;
+}
+
+
+bool term_frame_written_time( usize const frameIndex, nsecond *const outTime )
+{
+    assert( frameIndex < s_screenInfo.nbFramesSent );
+
+    if ( s_screenInfo.output.async )
+    {
+        if ( frameIndex >= term_writer_nb_frames_written() ) return false;
+        *outTime = term_writer_frame_written_time( frameIndex );
+        return true;
+    }
+
+    // Written by term_refresh() right away.
+    bool const inHistory = s_screenInfo.nbFramesWritten - frameIndex <= TERM_WRITE_TIMES_HISTORY;
+    *outTime = inHistory ? s_screenInfo.writeEnds[frameIndex % TERM_WRITE_TIMES_HISTORY] : 0;
+    return true;
+}
+
+
+struct TermFrameStats term_last_frame_stats( void )
+{
+    if ( !s_screenInfo.output.async ) return s_screenInfo.lastFrameStats;
+
+    struct TermFrameStats stats = term_writer_last_frame_stats();
+    stats.nbDroppedFrames = s_screenInfo.nbDroppedBeforeLastFrame;
+    return stats;
+}
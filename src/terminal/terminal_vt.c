@@ -0,0 +1,572 @@
+#include "terminal/terminal_vt.h"
+
+#include "terminal/terminal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+enum // Constants
+{
+    VT_MAX_PARAMETERS = 16,
+    VT_SYNCHRONIZED_UPDATE_MODE = 2026
+};
+
+
+enum ParserState
+{
+    ParserState_GROUND,
+    ParserState_ESCAPE,
+    ParserState_CSI,
+    ParserState_OSC,     // Operating system command (title), skipped until BEL or ST.
+    ParserState_OSC_ESC  // ESC received inside an OSC, expecting the '\' of ST.
+};
+
+
+struct CSIParameters
+{
+    u32 values[VT_MAX_PARAMETERS];
+    usize count;
+    bool privateMode; // '?' prefix
+    bool overflow;
+};
+
+
+struct VirtualTerminal
+{
+    struct Character *cells;
+    screensize size;
+
+    screenpos cursorPos;
+    bool wrapPending; // The last column has been written, the next character goes on the next line.
+    struct Style style;
+
+    utf16 highSurrogate;    // First half of a surrogate pair, waiting for the second one.
+    screenpos lastGlyphPos; // Where the combining marks go. 0 when nothing was printed since the last sequence.
+
+    // Scroll margins, starting at 1 as for a screenpos.
+    u16 marginTop;
+    u16 marginBottom;
+
+    bool synchronizedUpdate;
+
+    enum ParserState state;
+    struct CSIParameters params;
+
+    struct VTStats stats;
+};
+
+
+static struct VirtualTerminal s_vt;
+
+
+static struct Character *cell_at( usize const x, usize const y )
+{
+    return &s_vt.cells[y * s_vt.size.w + x];
+}
+
+
+// Erased cells keep the current colors, as most terminals do. The renderer always resets the style before that.
+static struct Character blank_character( void )
+{
+    return character_make( L' ', STYLE( s_vt.style.color ) );
+}
+
+
+static void clear_lines( usize const top, usize const count )
+{
+    struct Character const blank = blank_character();
+    for ( usize y = top; y < top + count; ++y )
+    {
+        for ( usize x = 0; x < s_vt.size.w; ++x )
+        {
+            *cell_at( x, y ) = blank;
+        }
+    }
+}
+
+
+static void reset_margins( void )
+{
+    s_vt.marginTop = 1;
+    s_vt.marginBottom = s_vt.size.h;
+}
+
+
+static void scroll_region( enum ScrollDirection const direction, u32 nbLines )
+{
+    usize const top = s_vt.marginTop - 1;
+    usize const height = s_vt.marginBottom - s_vt.marginTop + 1;
+    if ( nbLines > height ) nbLines = height;
+
+    usize const rowSize = s_vt.size.w * sizeof( struct Character );
+    usize const kept = height - nbLines;
+
+    if ( direction == ScrollDirection_UP )
+    {
+        memmove( cell_at( 0, top ), cell_at( 0, top + nbLines ), kept * rowSize );
+        clear_lines( top + kept, nbLines );
+    }
+    else
+    {
+        memmove( cell_at( 0, top + nbLines ), cell_at( 0, top ), kept * rowSize );
+        clear_lines( top, nbLines );
+    }
+}
+
+
+static void line_feed( void )
+{
+    if ( s_vt.cursorPos.y == s_vt.marginBottom )
+    {
+        scroll_region( ScrollDirection_UP, 1 );
+    }
+    else if ( s_vt.cursorPos.y < s_vt.size.h )
+    {
+        s_vt.cursorPos.y += 1;
+    }
+}
+
+
+static void move_cursor( u32 const x, u32 const y )
+{
+    s_vt.cursorPos.x = ( x < 1 ) ? 1 : ( x > s_vt.size.w ) ? s_vt.size.w : x;
+    s_vt.cursorPos.y = ( y < 1 ) ? 1 : ( y > s_vt.size.h ) ? s_vt.size.h : y;
+    s_vt.wrapPending = false;
+}
+
+
+static void print_glyph( termglyph const glyph )
+{
+    usize const width = glyph_width( glyph );
+
+    // A wide glyph can't start on the last column, it goes on the next line.
+    if ( s_vt.wrapPending || ( width > 1 && s_vt.cursorPos.x == s_vt.size.w ) )
+    {
+        s_vt.cursorPos.x = 1;
+        line_feed();
+        s_vt.wrapPending = false;
+    }
+
+    // Overwriting half of a wide glyph blanks its other half.
+    usize const x = s_vt.cursorPos.x - 1;
+    struct Character *const row = cell_at( 0, s_vt.cursorPos.y - 1 );
+    if ( row[x].glyph == GLYPH_WIDE_TAIL )
+    {
+        row[x - 1] = character_make( L' ', row[x - 1].style );
+    }
+    usize const last = x + width - 1;
+    if ( last + 1 < s_vt.size.w && row[last + 1].glyph == GLYPH_WIDE_TAIL )
+    {
+        row[last + 1] = character_make( L' ', row[last + 1].style );
+    }
+
+    row[x] = character_make( glyph, s_vt.style );
+    if ( width > 1 )
+    {
+        row[x + 1] = character_make( GLYPH_WIDE_TAIL, s_vt.style );
+    }
+    s_vt.lastGlyphPos = s_vt.cursorPos;
+    s_vt.stats.cellsWritten += 1;
+
+    if ( last + 1 == s_vt.size.w )
+        s_vt.wrapPending = true;
+    else
+        s_vt.cursorPos.x += width;
+}
+
+
+// Combining marks join the glyph printed right before them.
+static void combine_with_last_glyph( utf16 const mark )
+{
+    struct Character *const cell = cell_at( s_vt.lastGlyphPos.x - 1, s_vt.lastGlyphPos.y - 1 );
+
+    utf16 units[GLYPH_MAX_UNITS + 1];
+    usize nbUnits = glyph_encode( cell->glyph, units );
+    units[nbUnits++] = mark;
+    cell->glyph = glyph_intern( units, nbUnits );
+}
+
+
+static void print_unit( utf16 const unit )
+{
+    if ( unit >= 0xD800 && unit <= 0xDBFF )
+    {
+        s_vt.highSurrogate = unit;
+        return;
+    }
+
+    utf16 const highSurrogate = s_vt.highSurrogate;
+    s_vt.highSurrogate = 0;
+
+    if ( unit >= 0xDC00 && unit <= 0xDFFF )
+    {
+        utf16 const pair[] = { highSurrogate, unit };
+        print_glyph( highSurrogate != 0 ? glyph_intern( pair, ARR_COUNT( pair ) ) : GLYPH_REPLACEMENT );
+    }
+    else if ( glyph_is_combining( unit ) && s_vt.lastGlyphPos.raw != 0 )
+    {
+        combine_with_last_glyph( unit );
+    }
+    else
+    {
+        print_glyph( unit );
+    }
+}
+
+
+static u32 parameter_or( usize const idx, u32 const defaultValue )
+{
+    if ( idx >= s_vt.params.count || s_vt.params.values[idx] == 0 ) return defaultValue;
+    return s_vt.params.values[idx];
+}
+
+
+// Returns false if the parameter isn't something the renderer would send.
+static bool apply_sgr_parameter( u32 const code )
+{
+    struct Style *const style = &s_vt.style;
+
+    switch ( code )
+    {
+        case 0:  *style = STYLE_DEFAULT; return true;
+        case 1:  style->attr |= Attr_BOLD; return true;
+        case 2:  style->attr |= Attr_FAINT; return true;
+        case 3:  style->attr |= Attr_ITALIC; return true;
+        case 4:  style->attr |= Attr_UNDERLINE; return true;
+        case 5:  style->attr |= Attr_BLINK; return true;
+        case 9:  style->attr |= Attr_STRIKETHROUGH; return true;
+        case 22: style->attr &= ~( Attr_BOLD | Attr_FAINT ); return true;
+        case 23: style->attr &= ~Attr_ITALIC; return true;
+        case 24: style->attr &= ~Attr_UNDERLINE; return true;
+        case 25: style->attr &= ~Attr_BLINK; return true;
+        case 29: style->attr &= ~Attr_STRIKETHROUGH; return true;
+        case 39: style->color = ( style->color & 0x0F ) | ( Color_DEFAULT & 0xF0 ); return true;
+        case 49: style->color = ( style->color & 0xF0 ) | ( Color_DEFAULT & 0x0F ); return true;
+        default: break;
+    }
+
+    if ( code >= 30 && code <= 37 )   { style->color = ( style->color & 0x0F ) | ( ( code - 30 ) << 4 ); return true; }
+    if ( code >= 90 && code <= 97 )   { style->color = ( style->color & 0x0F ) | ( ( code - 90 + 8 ) << 4 ); return true; }
+    if ( code >= 40 && code <= 47 )   { style->color = ( style->color & 0xF0 ) | ( code - 40 ); return true; }
+    if ( code >= 100 && code <= 107 ) { style->color = ( style->color & 0xF0 ) | ( code - 100 + 8 ); return true; }
+
+    return false;
+}
+
+
+static bool apply_sgr( void )
+{
+    if ( s_vt.params.count == 0 ) return apply_sgr_parameter( 0 );
+
+    bool known = true;
+    for ( usize idx = 0; idx < s_vt.params.count; ++idx )
+    {
+        known = apply_sgr_parameter( s_vt.params.values[idx] ) && known;
+    }
+    return known;
+}
+
+
+static bool apply_private_mode( bool const enabled )
+{
+    for ( usize idx = 0; idx < s_vt.params.count; ++idx )
+    {
+        if ( s_vt.params.values[idx] == VT_SYNCHRONIZED_UPDATE_MODE )
+        {
+            s_vt.synchronizedUpdate = enabled;
+        }
+        // Other modes (cursor visibility, blinking, alternate buffer) don't change the content of the cells.
+    }
+    return true;
+}
+
+
+// DECSTBM, the cursor goes back to the home position whenever the margins are set.
+static bool apply_margins( void )
+{
+    u32 const top = parameter_or( 0, 1 );
+    u32 const bottom = parameter_or( 1, s_vt.size.h );
+    if ( top >= bottom || bottom > s_vt.size.h ) return false;
+
+    s_vt.marginTop = top;
+    s_vt.marginBottom = bottom;
+    move_cursor( 1, 1 );
+    return true;
+}
+
+
+static bool execute_csi( utf16 const final )
+{
+    if ( s_vt.params.overflow ) return false;
+
+    if ( s_vt.params.privateMode )
+    {
+        if ( final == L'h' ) return apply_private_mode( true );
+        if ( final == L'l' ) return apply_private_mode( false );
+        return false;
+    }
+
+    switch ( final )
+    {
+        case L'H': move_cursor( parameter_or( 1, 1 ), parameter_or( 0, 1 ) ); return true;
+        case L'm': return apply_sgr();
+        case L'r': return apply_margins();
+        case L'S': scroll_region( ScrollDirection_UP, parameter_or( 0, 1 ) ); return true;
+        case L'T': scroll_region( ScrollDirection_DOWN, parameter_or( 0, 1 ) ); return true;
+        default: return false;
+    }
+}
+
+
+static void begin_csi( void )
+{
+    s_vt.params = (struct CSIParameters) {};
+    s_vt.state = ParserState_CSI;
+}
+
+
+static void end_sequence( bool const known )
+{
+    s_vt.stats.nbSequences += 1;
+    if ( !known ) s_vt.stats.nbUnknownSequences += 1;
+    s_vt.state = ParserState_GROUND;
+}
+
+
+static void parse_csi( utf16 const unit )
+{
+    struct CSIParameters *const params = &s_vt.params;
+
+    if ( unit >= L'0' && unit <= L'9' )
+    {
+        if ( params->overflow ) return;
+        if ( params->count == 0 ) params->count = 1;
+
+        u32 *const value = &params->values[params->count - 1];
+        *value = *value * 10 + ( unit - L'0' );
+    }
+    else if ( unit == L';' )
+    {
+        // An empty parameter before the ';' still counts, as its default value.
+        if ( params->count == 0 ) params->count = 1;
+
+        if ( params->count < VT_MAX_PARAMETERS )
+            params->values[params->count++] = 0;
+        else
+            params->overflow = true;
+    }
+    else if ( unit == L'?' )
+    {
+        params->privateMode = true;
+    }
+    else if ( unit >= 0x40 && unit <= 0x7E )
+    {
+        end_sequence( execute_csi( unit ) );
+    }
+    else
+    {
+        // Intermediate bytes or anything else we don't expect from the renderer.
+        params->overflow = true;
+    }
+}
+
+
+static void parse_ground( utf16 const unit )
+{
+    if ( unit < 0x20 )
+    {
+        s_vt.highSurrogate = 0;
+        s_vt.lastGlyphPos = (screenpos) {};
+    }
+
+    switch ( unit )
+    {
+        case L'\x1b': s_vt.state = ParserState_ESCAPE; return;
+        case L'\r':   s_vt.cursorPos.x = 1; s_vt.wrapPending = false; return;
+        case L'\n':   line_feed(); s_vt.wrapPending = false; return;
+        case L'\b':   if ( s_vt.cursorPos.x > 1 ) s_vt.cursorPos.x -= 1; s_vt.wrapPending = false; return;
+        case L'\a':   return;
+        default: break;
+    }
+
+    if ( unit < 0x20 ) return; // Other C0 controls don't display anything.
+    print_unit( unit );
+}
+
+
+static void parse_unit( utf16 const unit )
+{
+    switch ( s_vt.state )
+    {
+        case ParserState_GROUND: parse_ground( unit ); return;
+        case ParserState_ESCAPE:
+        {
+            if ( unit == L'[' ) begin_csi();
+            else if ( unit == L']' ) s_vt.state = ParserState_OSC;
+            else end_sequence( false );
+            return;
+        }
+        case ParserState_CSI: parse_csi( unit ); return;
+        case ParserState_OSC:
+        {
+            if ( unit == L'\a' ) end_sequence( true );
+            else if ( unit == L'\x1b' ) s_vt.state = ParserState_OSC_ESC;
+            return;
+        }
+        case ParserState_OSC_ESC: end_sequence( unit == L'\\' ); return;
+    }
+}
+
+
+static bool alloc_cells( screensize const size, struct Character **outCells )
+{
+    *outCells = malloc( (usize)size.w * size.h * sizeof( struct Character ) );
+    if ( !*outCells )
+    {
+        fprintf( stderr, "[ERROR]: Failed to allocate the virtual terminal (%ux%u).\n", size.w, size.h );
+        return false;
+    }
+    return true;
+}
+
+
+bool vt_init( screensize const size )
+{
+    assert( size.w > 0 && size.h > 0 );
+
+    glyph_table_init();
+    s_vt = (struct VirtualTerminal) {};
+    if ( !alloc_cells( size, &s_vt.cells ) ) return false;
+
+    s_vt.size = size;
+    s_vt.style = STYLE_DEFAULT;
+    s_vt.cursorPos = SCREENPOS( 1, 1 );
+    s_vt.state = ParserState_GROUND;
+    reset_margins();
+    clear_lines( 0, size.h );
+
+    return true;
+}
+
+
+void vt_uninit( void )
+{
+    free( s_vt.cells );
+    s_vt = (struct VirtualTerminal) {};
+}
+
+
+void vt_feed( utf16 const *data, usize const size )
+{
+    assert( s_vt.cells );
+
+    s_vt.stats.nbFeeds += 1;
+    s_vt.stats.bytesFed += size * sizeof( utf16 );
+
+    for ( usize idx = 0; idx < size; ++idx )
+    {
+        parse_unit( data[idx] );
+    }
+}
+
+
+bool vt_resize( screensize const size )
+{
+    assert( size.w > 0 && size.h > 0 );
+
+    struct Character *cells;
+    if ( !alloc_cells( size, &cells ) ) return false;
+
+    struct Character const blank = character_default();
+    for ( usize y = 0; y < size.h; ++y )
+    {
+        for ( usize x = 0; x < size.w; ++x )
+        {
+            bool const kept = x < s_vt.size.w && y < s_vt.size.h;
+            cells[y * size.w + x] = kept ? *cell_at( x, y ) : blank;
+        }
+
+        // A wide glyph cut by the new width can't be displayed anymore.
+        struct Character *const last = &cells[y * size.w + size.w - 1];
+        if ( last->glyph != GLYPH_WIDE_TAIL && glyph_width( last->glyph ) > 1 )
+        {
+            *last = character_make( L' ', last->style );
+        }
+    }
+
+    free( s_vt.cells );
+    s_vt.cells = cells;
+    s_vt.size = size;
+
+    reset_margins();
+    move_cursor( s_vt.cursorPos.x, s_vt.cursorPos.y );
+    s_vt.lastGlyphPos = (screenpos) {};
+    return true;
+}
+
+
+usize vt_count_mismatches( void )
+{
+    screensize const size = term_size();
+    usize const height = ( size.h < s_vt.size.h ) ? size.h : s_vt.size.h;
+    usize const width = ( size.w < s_vt.size.w ) ? size.w : s_vt.size.w;
+
+    usize nbMismatches = 0;
+    for ( usize y = 0; y < height; ++y )
+    {
+        for ( usize x = 0; x < width; ++x )
+        {
+            struct Character const buffered = term_character_composited_at_pos( SCREENPOS( x + 1, y + 1 ) );
+            if ( character_needs_refresh( buffered ) || !character_equals( buffered, *cell_at( x, y ) ) )
+            {
+                nbMismatches += 1;
+            }
+        }
+    }
+    return nbMismatches;
+}
+
+
+screensize vt_size( void )
+{
+    return s_vt.size;
+}
+
+
+screenpos vt_cursor_pos( void )
+{
+    return s_vt.cursorPos;
+}
+
+
+struct Style vt_style( void )
+{
+    return s_vt.style;
+}
+
+
+bool vt_in_synchronized_update( void )
+{
+    return s_vt.synchronizedUpdate;
+}
+
+
+struct Character vt_character_at( screenpos const pos )
+{
+    assert( pos.x >= 1 && pos.x <= s_vt.size.w && pos.y >= 1 && pos.y <= s_vt.size.h );
+    return *cell_at( pos.x - 1, pos.y - 1 );
+}
+
+
+struct VTStats vt_stats( void )
+{
+    return s_vt.stats;
+}
+
+
+void vt_reset_stats( void )
+{
+    s_vt.stats = (struct VTStats) {};
+}
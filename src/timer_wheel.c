@@ -0,0 +1,249 @@
+#include "timer_wheel.h"
+
+#include <string.h>
+
+
+enum // Constants
+{
+    TICK_NSEC = Time_MSEC_IN_NSEC,
+
+    // Each slot of a level spans a whole revolution of the level below it.
+    SLOT_BITS = 6,
+    SLOTS_PER_LEVEL = 1 << SLOT_BITS,
+    LEVELS_COUNT = 4,
+    // About 4.6 hours. Timers further away wait in the last level, and are placed again each time it turns.
+    MAX_RANGE_TICKS = 1 << ( SLOT_BITS * LEVELS_COUNT ),
+    // Level of the timers in s_pending.
+    PENDING_LEVEL = LEVELS_COUNT
+};
+
+
+static struct Timer *s_slots[LEVELS_COUNT][SLOTS_PER_LEVEL];
+// One bit per non empty slot, to skip the empty ones.
+static u64 s_occupiedSlots[LEVELS_COUNT];
+// Every tick up to this one has been run.
+static u64 s_currentTick;
+static usize s_nbScheduled;
+// While an advance runs, the tick it goes up to. The timers scheduled by its callbacks that would be due by then wait
+// in s_pending, to be placed in the wheel once it is over.
+static bool s_advancing = false;
+static u64 s_advanceTargetTick;
+static struct Timer *s_pending;
+static TimerDispatchObserverCb s_dispatchObserver = NULL;
+
+
+static u64 level_shift( usize const level )
+{
+    return level * SLOT_BITS;
+}
+
+
+static void insert( struct Timer *const timer )
+{
+    assert( timer->expiresTick >= s_currentTick );
+
+    u64 const delta = timer->expiresTick - s_currentTick;
+    timer->slotTick = ( delta < MAX_RANGE_TICKS ) ? timer->expiresTick : s_currentTick + MAX_RANGE_TICKS - 1;
+
+    usize level = 0;
+    while ( level < LEVELS_COUNT - 1 && ( timer->slotTick - s_currentTick ) >= ( (u64)1 << level_shift( level + 1 ) ) )
+    {
+        level += 1;
+    }
+    usize const slot = ( timer->slotTick >> level_shift( level ) ) & ( SLOTS_PER_LEVEL - 1 );
+
+    struct Timer **const head = &s_slots[level][slot];
+    timer->prev = NULL;
+    timer->next = *head;
+    if ( *head ) ( *head )->prev = timer;
+    *head = timer;
+
+    timer->level = level;
+    timer->slot = slot;
+    s_occupiedSlots[level] |= (u64)1 << slot;
+}
+
+
+static void push_pending( struct Timer *const timer )
+{
+    timer->prev = NULL;
+    timer->next = s_pending;
+    if ( s_pending ) s_pending->prev = timer;
+    s_pending = timer;
+    timer->level = PENDING_LEVEL;
+}
+
+
+static void unlink( struct Timer *const timer )
+{
+    struct Timer **const head = ( timer->level == PENDING_LEVEL ) ? &s_pending : &s_slots[timer->level][timer->slot];
+    if ( timer->prev ) timer->prev->next = timer->next;
+    else *head = timer->next;
+    if ( timer->next ) timer->next->prev = timer->prev;
+
+    if ( timer->level != PENDING_LEVEL && !*head )
+    {
+        s_occupiedSlots[timer->level] &= ~( (u64)1 << timer->slot );
+    }
+    timer->prev = NULL;
+    timer->next = NULL;
+}
+
+
+// The timers of the slot of a higher level that just came up get closer to their deadline: placed again, in the
+// lower levels.
+static void cascade( usize const level )
+{
+    usize const slot = ( s_currentTick >> level_shift( level ) ) & ( SLOTS_PER_LEVEL - 1 );
+    struct Timer *timer = s_slots[level][slot];
+
+    s_slots[level][slot] = NULL;
+    s_occupiedSlots[level] &= ~( (u64)1 << slot );
+
+    while ( timer )
+    {
+        struct Timer *const next = timer->next;
+        insert( timer );
+        timer = next;
+    }
+}
+
+
+static void run_current_tick( nsecond const now )
+{
+    usize const slot = s_currentTick & ( SLOTS_PER_LEVEL - 1 );
+
+    // One at a time: a callback may cancel or schedule the other timers.
+    while ( s_slots[0][slot] )
+    {
+        struct Timer *const timer = s_slots[0][slot];
+        unlink( timer );
+        timer->scheduled = false;
+        s_nbScheduled -= 1;
+
+        if ( s_dispatchObserver ) s_dispatchObserver( timer->userData, true );
+        timer->callback( timer->userData, now );
+        if ( s_dispatchObserver ) s_dispatchObserver( timer->userData, false );
+    }
+}
+
+
+void timer_wheel_init( void )
+{
+    memset( s_slots, 0, sizeof( s_slots ) );
+    memset( s_occupiedSlots, 0, sizeof( s_occupiedSlots ) );
+    s_nbScheduled = 0;
+    s_pending = NULL;
+    s_currentTick = time_get_timestamp_nsec() / TICK_NSEC;
+}
+
+
+void timer_wheel_schedule( struct Timer *const timer, nsecond const deadline, TimerCallback const callback, void *const userData )
+{
+    assert( timer && callback );
+
+    timer_wheel_cancel( timer );
+
+    // Rounded up, so that it doesn't run before the deadline.
+    u64 const deadlineTick = ( deadline + TICK_NSEC - 1 ) / TICK_NSEC;
+    timer->expiresTick = ( deadlineTick > s_currentTick ) ? deadlineTick : s_currentTick + 1;
+    timer->callback = callback;
+    timer->userData = userData;
+    timer->scheduled = true;
+    s_nbScheduled += 1;
+
+    if ( s_advancing && timer->expiresTick <= s_advanceTargetTick ) push_pending( timer );
+    else insert( timer );
+}
+
+
+void timer_wheel_cancel( struct Timer *const timer )
+{
+    assert( timer );
+    if ( !timer->scheduled ) return;
+
+    unlink( timer );
+    timer->scheduled = false;
+    s_nbScheduled -= 1;
+}
+
+
+bool timer_wheel_is_scheduled( struct Timer const *const timer )
+{
+    return timer->scheduled;
+}
+
+
+void timer_wheel_advance( nsecond const now )
+{
+    assert( !s_advancing );
+    u64 const targetTick = now / TICK_NSEC;
+    s_advancing = true;
+    s_advanceTargetTick = targetTick;
+
+    while ( s_currentTick < targetTick )
+    {
+        // The ticks until the next cascade of the lowest non empty level have nothing to run: skipped at once.
+        usize lowestLevel = 0;
+        while ( lowestLevel < LEVELS_COUNT && s_occupiedSlots[lowestLevel] == 0 ) lowestLevel += 1;
+
+        if ( lowestLevel == LEVELS_COUNT )
+        {
+            s_currentTick = targetTick;
+            break;
+        }
+        if ( lowestLevel > 0 )
+        {
+            u64 const nextCascade = ( s_currentTick | ( ( (u64)1 << level_shift( lowestLevel ) ) - 1 ) ) + 1;
+            s_currentTick = ( ( nextCascade < targetTick ) ? nextCascade : targetTick ) - 1;
+        }
+
+        s_currentTick += 1;
+        for ( usize level = LEVELS_COUNT - 1; level > 0; --level )
+        {
+            if ( ( s_currentTick & ( ( (u64)1 << level_shift( level ) ) - 1 ) ) == 0 ) cascade( level );
+        }
+        run_current_tick( now );
+    }
+
+    s_advancing = false;
+    while ( s_pending )
+    {
+        struct Timer *const timer = s_pending;
+        unlink( timer );
+        timer->expiresTick = s_currentTick + 1;
+        insert( timer );
+    }
+}
+
+
+nsecond timer_wheel_next_deadline( void )
+{
+    if ( s_nbScheduled == 0 ) return 0;
+
+    u64 nextTick = UINT64_MAX;
+    for ( usize level = 0; level < LEVELS_COUNT; ++level )
+    {
+        if ( s_occupiedSlots[level] == 0 ) continue;
+
+        // The slots come up in turn from the one after the current one: the first non empty slot holds the earliest
+        // timers of the level.
+        usize const first = ( ( s_currentTick >> level_shift( level ) ) + 1 ) & ( SLOTS_PER_LEVEL - 1 );
+        u64 const rotated = ( s_occupiedSlots[level] >> first ) | ( first ? s_occupiedSlots[level] << ( SLOTS_PER_LEVEL - first ) : 0 );
+        usize const slot = ( first + __builtin_ctzll( rotated ) ) & ( SLOTS_PER_LEVEL - 1 );
+
+        // Timers beyond the range only end the wait to be placed again.
+        for ( struct Timer const *timer = s_slots[level][slot]; timer; timer = timer->next )
+        {
+            if ( timer->slotTick < nextTick ) nextTick = timer->slotTick;
+        }
+    }
+
+    return nextTick * TICK_NSEC;
+}
+
+
+void timer_wheel_set_dispatch_observer( TimerDispatchObserverCb const observer )
+{
+    s_dispatchObserver = observer;
+}
@@ -0,0 +1,166 @@
+#include "trace.h"
+
+#ifdef TRACE
+
+#include "time_units.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+enum // Constants
+{
+    TRACE_MAX_THREADS = 8,
+    // Scopes kept per thread, about 1.5 MB each.
+    TRACE_RING_CAPACITY = 1 << 16,
+    // Scopes nested deeper are not recorded.
+    TRACE_MAX_DEPTH = 32
+};
+
+
+struct TraceScope
+{
+    char const *name;
+    nsecond begin;
+    nsecond duration;
+};
+
+
+struct OpenScope
+{
+    char const *name;
+    nsecond begin;
+};
+
+
+struct TraceRing
+{
+    struct TraceScope scopes[TRACE_RING_CAPACITY];
+    // Since the start, the next scope going at nbRecorded % TRACE_RING_CAPACITY.
+    usize nbRecorded;
+
+    struct OpenScope openScopes[TRACE_MAX_DEPTH];
+    usize depth;
+
+    u32 threadId;
+};
+
+
+static struct TraceRing *_Atomic s_rings[TRACE_MAX_THREADS];
+static atomic_uint s_nbRings;
+static _Thread_local struct TraceRing *s_threadRing;
+static _Thread_local bool s_threadRingFailed;
+
+
+static struct TraceRing *thread_ring( void )
+{
+    if ( s_threadRing || s_threadRingFailed ) return s_threadRing;
+
+    unsigned const idx = atomic_fetch_add( &s_nbRings, 1 );
+    if ( idx >= TRACE_MAX_THREADS )
+    {
+        fprintf( stderr, "[ERROR]: Can't trace more than %u threads.\n", TRACE_MAX_THREADS );
+        s_threadRingFailed = true;
+        return NULL;
+    }
+
+    struct TraceRing *const ring = calloc( 1, sizeof( struct TraceRing ) );
+    if ( !ring )
+    {
+        fprintf( stderr, "[ERROR]: Failed to allocate a trace ring buffer.\n" );
+        s_threadRingFailed = true;
+        return NULL;
+    }
+
+    ring->threadId = idx + 1;
+    atomic_store( &s_rings[idx], ring );
+    s_threadRing = ring;
+    return ring;
+}
+
+
+void trace_begin( char const *const name )
+{
+    struct TraceRing *const ring = thread_ring();
+    if ( !ring ) return;
+
+    if ( ring->depth < TRACE_MAX_DEPTH )
+    {
+        ring->openScopes[ring->depth] = (struct OpenScope) { .name = name, .begin = time_get_timestamp_nsec() };
+    }
+    ring->depth += 1;
+}
+
+
+void trace_end( void )
+{
+    struct TraceRing *const ring = s_threadRing;
+    if ( !ring ) return;
+
+    assert( ring->depth > 0 );
+    ring->depth -= 1;
+    if ( ring->depth >= TRACE_MAX_DEPTH ) return;
+
+    struct OpenScope const *open = &ring->openScopes[ring->depth];
+    ring->scopes[ring->nbRecorded % TRACE_RING_CAPACITY] = (struct TraceScope) {
+        .name = open->name,
+        .begin = open->begin,
+        .duration = time_get_timestamp_nsec() - open->begin
+    };
+    ring->nbRecorded += 1;
+}
+
+
+static void write_json_string( FILE *const file, char const *str )
+{
+    fputc( '"', file );
+    for ( ; *str; ++str )
+    {
+        if ( *str == '"' || *str == '\\' ) fputc( '\\', file );
+        fputc( *str, file );
+    }
+    fputc( '"', file );
+}
+
+
+bool trace_flush( char const *const path )
+{
+    FILE *const file = fopen( path, "w" );
+    if ( !file )
+    {
+        fprintf( stderr, "[ERROR]: Failed to open %s to write the trace.\n", path );
+        return false;
+    }
+
+    fprintf( file, "{\"traceEvents\":[" );
+    bool first = true;
+
+    unsigned const nbRings = atomic_load( &s_nbRings );
+    for ( unsigned ringIdx = 0; ringIdx < nbRings && ringIdx < TRACE_MAX_THREADS; ++ringIdx )
+    {
+        struct TraceRing const *ring = atomic_load( &s_rings[ringIdx] );
+        if ( !ring ) continue;
+
+        usize const nbKept = ( ring->nbRecorded < TRACE_RING_CAPACITY ) ? ring->nbRecorded : TRACE_RING_CAPACITY;
+        for ( usize idx = ring->nbRecorded - nbKept; idx < ring->nbRecorded; ++idx )
+        {
+            struct TraceScope const *scope = &ring->scopes[idx % TRACE_RING_CAPACITY];
+
+            // Complete events, in microseconds.
+            fprintf( file, first ? "\n{\"name\":" : ",\n{\"name\":" );
+            write_json_string( file, scope->name );
+            fprintf( file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu.%03llu,\"dur\":%llu.%03llu}",
+                ring->threadId,
+                (unsigned long long)( scope->begin / Time_USEC_IN_NSEC ), (unsigned long long)( scope->begin % Time_USEC_IN_NSEC ),
+                (unsigned long long)( scope->duration / Time_USEC_IN_NSEC ), (unsigned long long)( scope->duration % Time_USEC_IN_NSEC ) );
+            first = false;
+        }
+    }
+
+    fprintf( file, "\n]}\n" );
+    fclose( file );
+    return true;
+}
+
+#endif
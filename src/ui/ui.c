@@ -1,5 +1,9 @@
 #include "ui/ui.h"
 #include "ui/widgets.h"
+#include "events.h"
+#include "terminal/terminal.h"
+#include "timer_wheel.h"
+#include "trace.h"
 
 #include <stdlib.h>
 
@@ -16,17 +20,72 @@ enum WidgetId
     WidgetId_PEG_SELECTOR,
     WidgetId_GAME_BOARD,
     WidgetId_PEG_TRACKING,
+    WidgetId_INPUT_LATENCY,
 
     WidgetId_Count
 };
 
 
+enum // Constants
+{
+    // Events triggered from an event callback, and so on.
+    MAX_NESTED_DISPATCHES = 16
+};
+
+// The damage of a widget is counted for the owner WidgetId + 1, 0 being for everything else.
+static_assert( (usize)WidgetId_Count < (usize)TERM_MAX_DAMAGE_OWNERS );
+
+
 typedef struct Widget * ( * WidgetCreateFunc )( void );
 
 static struct Widget *s_widgets[WidgetId_Count];
 static bool s_widgetsEnabled[WidgetId_Count];
 static enum UIScene s_currScene;
 
+static u8 s_previousDamageOwners[MAX_NESTED_DISPATCHES];
+static usize s_nbNestedDispatches;
+
+
+static u8 damage_owner_of( void const *subscriber )
+{
+    for ( usize idx = 0; idx < WidgetId_Count; ++idx )
+    {
+        if ( s_widgets[idx] && s_widgets[idx] == subscriber ) return idx + 1;
+    }
+    return 0;
+}
+
+
+static void begin_damage_owner( u8 const owner )
+{
+    assert( s_nbNestedDispatches < MAX_NESTED_DISPATCHES );
+    s_previousDamageOwners[s_nbNestedDispatches++] = term_damage_set_owner( owner );
+}
+
+
+static void end_damage_owner( void )
+{
+    assert( s_nbNestedDispatches > 0 );
+    term_damage_set_owner( s_previousDamageOwners[--s_nbNestedDispatches] );
+}
+
+
+// What a widget draws from its event and timer callbacks is counted for it as well.
+static void on_widget_dispatch( void *subscriber, bool const begin )
+{
+    if ( begin )
+    {
+        u8 const owner = damage_owner_of( subscriber );
+        TRACE_BEGIN( owner != 0 ? s_widgets[owner - 1]->name : "subscriber" );
+        begin_damage_owner( owner );
+    }
+    else
+    {
+        end_damage_owner();
+        TRACE_END();
+    }
+}
+
 
 static void init_widget( enum WidgetId const id, WidgetCreateFunc const createFunction )
 {
@@ -41,6 +100,7 @@ static void init_widget( enum WidgetId const id, WidgetCreateFunc const createFu
 bool ui_init( void )
 {
     s_currScene = UIScene_NONE;
+    timer_wheel_init();
 
     init_widget( WidgetId_FRAMERATE, widget_framerate_create );
     init_widget( WidgetId_SCREENSIZE, widget_screensize_create );
@@ -52,13 +112,19 @@ bool ui_init( void )
     init_widget( WidgetId_PEG_SELECTOR, widget_peg_selector_create );
     init_widget( WidgetId_GAME_BOARD, widget_game_board_create );
     init_widget( WidgetId_PEG_TRACKING, widget_peg_tracking_create );
+    init_widget( WidgetId_INPUT_LATENCY, widget_input_latency_create );
 
+    event_set_dispatch_observer( on_widget_dispatch );
+    timer_wheel_set_dispatch_observer( on_widget_dispatch );
     return true;
 }
 
 
 void ui_uninit( void )
 {
+    event_set_dispatch_observer( NULL );
+    timer_wheel_set_dispatch_observer( NULL );
+
     for ( usize idx = 0; idx < WidgetId_Count; ++idx )
     {
         if ( s_widgets[idx] )
@@ -72,17 +138,30 @@ void ui_uninit( void )
 
 void ui_frame( void )
 {
+    // The widgets changing with time first, only when they do.
+    timer_wheel_advance( time_get_timestamp_nsec() );
+
     for ( usize idx = 0; idx < WidgetId_Count; ++idx )
     {
         struct Widget *widget = s_widgets[idx];
         if ( widget && s_widgetsEnabled[idx] && widget->frameCb )
         {
+            TRACE_BEGIN( widget->name );
+            begin_damage_owner( idx + 1 );
             widget->frameCb( widget );
+            end_damage_owner();
+            TRACE_END();
         }
     }
 }
 
 
+nsecond ui_next_update_time( void )
+{
+    return timer_wheel_next_deadline();
+}
+
+
 bool ui_change_scene( enum UIScene const scene )
 {
     if ( s_currScene == scene ) return false;
@@ -98,7 +177,9 @@ bool ui_change_scene( enum UIScene const scene )
         {
             if ( widget->disableCb )
             {
+                begin_damage_owner( idx + 1 );
                 widget->disableCb( widget );
+                end_damage_owner();
             }
             s_widgetsEnabled[idx] = false;
         }
@@ -113,7 +194,9 @@ bool ui_change_scene( enum UIScene const scene )
         {
             if ( widget->enableCb )
             {
+                begin_damage_owner( idx + 1 );
                 widget->enableCb( widget );
+                end_damage_owner();
             }
             s_widgetsEnabled[idx] = true;
         }
@@ -121,3 +204,19 @@ bool ui_change_scene( enum UIScene const scene )
 
     return true;
 }
+
+
+usize ui_get_widgets_damage( struct UIWidgetDamage *const outDamage, usize const capacity )
+{
+    usize count = 0;
+    for ( usize idx = 0; idx < WidgetId_Count && count < capacity; ++idx )
+    {
+        if ( !s_widgets[idx] ) continue;
+
+        outDamage[count++] = (struct UIWidgetDamage) {
+            .name = s_widgets[idx]->name,
+            .totals = term_damage_totals( idx + 1 )
+        };
+    }
+    return count;
+}
@@ -4,18 +4,64 @@
 #include "terminal/terminal.h"
 #include "rect.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 
 
+enum // Constants
+{
+    // Longer than any of the rects.
+    FIELD_BUFFER_SIZE = 64
+};
+
+
 struct WidgetFramerate
 {
     struct Widget base;
 
     struct Rect rect;
     usize lastAverageFPS;
+
+    struct Rect outputRect;
+    struct TermFrameStats lastFrameStats;
+
+    struct Rect timesRect;
+    struct FrameHistogramTimes lastFrameTimes;
 };
 
 
+static struct FrameHistogramTimes current_frame_times( void )
+{
+    return frame_histogram_times( fpscounter_frame_histogram( fpscounter_get_instance() ) );
+}
+
+
+// Padded with spaces to the width of the rect: a shorter text than the previous one doesn't leave its end behind.
+static void write_field( struct Rect const *rect, utf16 const *text )
+{
+    cursor_update_pos( rect_get_ul_corner( rect ) );
+    style_update( STYLE_WITH_ATTR( FGColor_BRIGHT_BLACK, Attr_FAINT ) );
+    term_write( L"%-*.*ls", (int)rect->size.w, (int)rect->size.w, text );
+}
+
+
+static void draw_frame_times( struct WidgetFramerate *widget, struct FrameHistogramTimes const times )
+{
+    utf16 text[FIELD_BUFFER_SIZE];
+    snwprintf( text, ARR_COUNT( text ), L"p50 %2u.%ums p99 %2u.%ums max %3u.%ums",
+        times.p50 / 10, times.p50 % 10, times.p99 / 10, times.p99 % 10, times.max / 10, times.max % 10 );
+    write_field( &widget->timesRect, text );
+}
+
+
+static void draw_frame_stats( struct WidgetFramerate *widget, struct TermFrameStats const stats )
+{
+    utf16 text[FIELD_BUFFER_SIZE];
+    snwprintf( text, ARR_COUNT( text ), L"Frame: %5u bytes, %u writes", (u32)stats.bytesWritten, (u32)stats.nbSyscalls );
+    write_field( &widget->outputRect, text );
+}
+
+
 static void enable_callback( struct Widget *base )
 {
     struct WidgetFramerate *widget = (struct WidgetFramerate *)base;
@@ -27,6 +73,16 @@ static void enable_callback( struct Widget *base )
     term_write( L"FPS" );
 
     widget->lastAverageFPS = 0;
+
+    widget->lastFrameStats = term_last_frame_stats();
+    draw_frame_stats( widget, widget->lastFrameStats );
+
+    widget->lastFrameTimes = current_frame_times();
+    draw_frame_times( widget, widget->lastFrameTimes );
+
+    term_add_cosmetic_area( rect_get_ul_corner( &widget->rect ), widget->rect.size );
+    term_add_cosmetic_area( rect_get_ul_corner( &widget->outputRect ), widget->outputRect.size );
+    term_add_cosmetic_area( rect_get_ul_corner( &widget->timesRect ), widget->timesRect.size );
 }
 
 
@@ -34,7 +90,13 @@ static void disable_callback( struct Widget *base )
 {
     struct WidgetFramerate *widget = (struct WidgetFramerate *)base;
 
+    term_remove_cosmetic_area( rect_get_ul_corner( &widget->rect ), widget->rect.size );
+    term_remove_cosmetic_area( rect_get_ul_corner( &widget->outputRect ), widget->outputRect.size );
+    term_remove_cosmetic_area( rect_get_ul_corner( &widget->timesRect ), widget->timesRect.size );
+
     rect_clear( &widget->rect );
+    rect_clear( &widget->outputRect );
+    rect_clear( &widget->timesRect );
 }
 
 
@@ -51,6 +113,20 @@ static void frame_callback( struct Widget *base )
 
         widget->lastAverageFPS = lastAverageFPS;
     }
+
+    struct TermFrameStats const frameStats = term_last_frame_stats();
+    if ( frameStats.bytesWritten != widget->lastFrameStats.bytesWritten || frameStats.nbSyscalls != widget->lastFrameStats.nbSyscalls )
+    {
+        draw_frame_stats( widget, frameStats );
+        widget->lastFrameStats = frameStats;
+    }
+
+    struct FrameHistogramTimes const frameTimes = current_frame_times();
+    if ( frameTimes.p50 != widget->lastFrameTimes.p50 || frameTimes.p99 != widget->lastFrameTimes.p99 || frameTimes.max != widget->lastFrameTimes.max )
+    {
+        draw_frame_times( widget, frameTimes );
+        widget->lastFrameTimes = frameTimes;
+    }
 }
 
 
@@ -68,6 +144,8 @@ struct Widget *widget_framerate_create( void )
     // Widget specific
 
     widget->rect = rect_make( SCREENPOS( 1, 1 ), VEC2U16( 7, 1 ) );
+    widget->outputRect = rect_make( SCREENPOS( 54, 1 ), VEC2U16( 30, 1 ) );
+    widget->timesRect = rect_make( SCREENPOS( 86, 1 ), VEC2U16( 35, 1 ) );
 
     return (struct Widget *)widget;
 }
@@ -12,7 +12,8 @@
 enum // Constants
 {
     TOTAL_BOARD_WIDTH = 78,
-    ROWS_DISPLAYED = 4
+    ROWS_DISPLAYED = 4,
+    ROW_HEIGHT = 6 // Including the line separating it from the next row.
 };
 
 enum ButtonIdx
@@ -47,10 +48,15 @@ struct WidgetGameBoard
 
 static inline void draw_character_n_times( utf16 const character, usize const n )
 {
-	for ( usize x = 0; x < n; ++x )
-	{
-		term_write( L"%lc", character );
-	}
+	screenpos const pos = cursor_pos();
+	term_fill( pos, VEC2U16( n, 1 ), character_make( character, style_current() ) );
+	cursor_update_pos( SCREENPOS( pos.x + n, pos.y ) );
+}
+
+
+static inline void draw_character( utf16 const character )
+{
+	term_put_run( cursor_pos(), style_current(), &character, 1 );
 }
 
 
@@ -69,9 +75,9 @@ static void draw_internal_board_lines( struct WidgetGameBoard *widget )
 	// Line that separates buttons from the rest of the game
 	cursor_update_yx( ul.y + widget->box.size.h - 3, ul.x );
 	style_update( STYLE( FGColor_BRIGHT_BLACK ) );
-	term_write( L"%lc", L'├' );
+	draw_character( L'├' );
 	draw_character_n_times( L'─', TOTAL_BOARD_WIDTH - 2 );
-	term_write( L"%lc", L'┤' );
+	draw_character( L'┤' );
 }
 
 
@@ -270,6 +276,31 @@ static void display_moved( struct WidgetGameBoard *widget, bool const historyUp
 }
 
 
+// Moves the display by a single turn, when neither the old nor the new display contains the solution.
+// The rows already drawn are shifted by the terminal, so only the newly displayed turn has to be drawn.
+static void display_scrolled( struct WidgetGameBoard *widget, bool const historyUp )
+{
+    screenpos const ul = rect_get_ul_corner( &widget->box );
+    screenpos const areaUL = SCREENPOS( ul.x + 1, ul.y + 1 );
+    vec2u16 const areaSize = VEC2U16( TOTAL_BOARD_WIDTH - 2, ROWS_DISPLAYED * ROW_HEIGHT - 1 );
+    term_scroll( areaUL, areaSize, historyUp ? ScrollDirection_DOWN : ScrollDirection_UP, ROW_HEIGHT );
+
+    // The line separating the rows has been cleared along with the new row.
+    draw_internal_board_lines( widget );
+
+    usize const rowIdx = historyUp ? 0 : ROWS_DISPLAYED - 1;
+    usize const dispTurn = ( widget->lastDispTurn - ( ROWS_DISPLAYED - 1 ) ) + rowIdx;
+    for ( usize x = 0; x < widget->nbPegsPerTurn; ++x )
+    {
+        draw_peg_at( widget, dispTurn, x, mastermind_get_peg( dispTurn, x ) );
+        draw_pin_at( widget, dispTurn, x, mastermind_get_pin( dispTurn, x ) );
+    }
+
+    // The current turn may have changed since the labels were drawn.
+    draw_turns( widget );
+}
+
+
 static void on_trigger_confirm_turn( bool )
 {
     struct Request const req = (struct Request) {
@@ -351,7 +382,7 @@ static enum EventPropagation on_event_callback( void *subscriber, struct Event c
                 if ( widget->lastDispTurn > 4 )
                 {
                     widget->lastDispTurn -= 1;
-                    display_moved( widget, true );
+                    display_scrolled( widget, true );
                 }
                 else if ( widget->lastDispTurn == Mastermind_SOLUTION_TURN )
                 {
@@ -367,8 +398,12 @@ static enum EventPropagation on_event_callback( void *subscriber, struct Event c
                     if ( widget->lastDispTurn > widget->nbTurns )
                     {
                         widget->lastDispTurn = Mastermind_SOLUTION_TURN;
+                        display_moved( widget, false );
+                    }
+                    else
+                    {
+                        display_scrolled( widget, false );
                     }
-                    display_moved( widget, false );
                 }
             }
             break;
@@ -395,8 +430,12 @@ static enum EventPropagation on_event_callback( void *subscriber, struct Event c
                 if ( widget->lastDispTurn > widget->nbTurns )
                 {
                     widget->lastDispTurn = Mastermind_SOLUTION_TURN;
+                    display_moved( widget, false );
+                }
+                else
+                {
+                    display_scrolled( widget, false );
                 }
-                display_moved( widget, false );
             }
             break;
         }
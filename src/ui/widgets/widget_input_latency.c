@@ -0,0 +1,166 @@
+#include "ui/widgets.h"
+#include "events.h"
+#include "input_latency.h"
+#include "keybindings.h"
+#include "terminal/terminal.h"
+#include "timer_wheel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+enum // Constants
+{
+    OVERLAY_WIDTH = 48,
+    // A header, then a line per request type.
+    OVERLAY_HEIGHT = 1 + RequestType_Count,
+    OVERLAY_REFRESH_NSEC = 250 * Time_MSEC_IN_NSEC,
+    // Longest time fitting in its column, in tenths of ms ("999.9ms").
+    MAX_SHOWN_TENTHS_OF_MSEC = 9999,
+    TIME_BUFFER_SIZE = 8
+};
+
+
+// Input to display latency per request type, on a layer over the rest of the screen. Toggled with a key.
+// Only the requests that wrote to the screen are counted, each up to the first frame sent after it (see input_latency.h).
+struct WidgetInputLatency
+{
+    struct Widget base;
+
+    struct TermLayer *layer;
+    bool shown;
+    struct Timer refreshTimer;
+    struct Character content[OVERLAY_WIDTH * OVERLAY_HEIGHT];
+};
+
+
+static void write_line( struct WidgetInputLatency *widget, usize const line, char const *text, struct Style const style )
+{
+    struct Character *const characters = &widget->content[line * OVERLAY_WIDTH];
+    for ( usize x = 0; x < OVERLAY_WIDTH; ++x )
+    {
+        // Only ASCII: each code unit is its own glyph.
+        termglyph const glyph = ( *text != '\0' ) ? (termglyph)*text++ : L' ';
+        characters[x] = character_make( glyph, style );
+    }
+}
+
+
+// Times past the column are shown as ">999ms".
+static void format_time( char *const out, usize const size, u32 const tenthsOfMsec )
+{
+    if ( tenthsOfMsec > MAX_SHOWN_TENTHS_OF_MSEC ) snprintf( out, size, ">999ms" );
+    else snprintf( out, size, "%3u.%ums", tenthsOfMsec / 10, tenthsOfMsec % 10 );
+}
+
+
+static void update_content( struct WidgetInputLatency *widget )
+{
+    struct Style const headerStyle = STYLE_WITH_ATTR( FGColor_WHITE, Attr_BOLD );
+    struct Style const style = STYLE( FGColor_WHITE );
+
+    char text[OVERLAY_WIDTH + 1];
+    snprintf( text, sizeof( text ), " %-15s %6s %7s %7s %7s", "Input latency", "count", "p50", "p99", "max" );
+    write_line( widget, 0, text, headerStyle );
+
+    usize line = 1;
+    for ( usize type = 0; type < RequestType_Count; ++type )
+    {
+        struct FrameHistogram const *histogram = input_latency_histogram( type );
+        if ( frame_histogram_count( histogram ) == 0 ) continue;
+
+        struct FrameHistogramTimes const times = frame_histogram_times( histogram );
+        char p50Text[TIME_BUFFER_SIZE], p99Text[TIME_BUFFER_SIZE], maxText[TIME_BUFFER_SIZE];
+        format_time( p50Text, sizeof( p50Text ), times.p50 );
+        format_time( p99Text, sizeof( p99Text ), times.p99 );
+        format_time( maxText, sizeof( maxText ), times.max );
+        snprintf( text, sizeof( text ), " %-15s %6lu %7s %7s %7s",
+            input_latency_request_name( type ), (unsigned long)frame_histogram_count( histogram ), p50Text, p99Text, maxText );
+        write_line( widget, line++, text, style );
+    }
+    for ( ; line < OVERLAY_HEIGHT; ++line )
+    {
+        write_line( widget, line, "", style );
+    }
+
+    term_layer_set_content( widget->layer, widget->content );
+}
+
+
+static void on_refresh_timer( void *userData, nsecond const now )
+{
+    struct WidgetInputLatency *widget = (struct WidgetInputLatency *)userData;
+
+    update_content( widget );
+    timer_wheel_schedule( &widget->refreshTimer, now + OVERLAY_REFRESH_NSEC, on_refresh_timer, widget );
+}
+
+
+static void show_overlay( struct WidgetInputLatency *widget )
+{
+    widget->shown = true;
+    update_content( widget );
+    term_layer_show( widget->layer );
+    timer_wheel_schedule( &widget->refreshTimer, time_get_timestamp_nsec() + OVERLAY_REFRESH_NSEC, on_refresh_timer, widget );
+}
+
+
+static void hide_overlay( struct WidgetInputLatency *widget )
+{
+    widget->shown = false;
+    timer_wheel_cancel( &widget->refreshTimer );
+    term_layer_hide( widget->layer );
+}
+
+
+static enum EventPropagation on_event_callback( void *subscriber, struct Event const *event )
+{
+    struct WidgetInputLatency *const widget = (struct WidgetInputLatency *)subscriber;
+
+    if ( widget->layer && event->userInput.input == keybinding_get_binded_key( KeyBinding_LATENCY_OVERLAY ) )
+    {
+        if ( widget->shown ) hide_overlay( widget );
+        else show_overlay( widget );
+    }
+    return EventPropagation_CONTINUE;
+}
+
+
+static void enable_callback( struct Widget *base )
+{
+    struct WidgetInputLatency *const widget = (struct WidgetInputLatency *)base;
+    // Without its layer, the widget stays enabled but the overlay can't be shown.
+    widget->layer = term_layer_create( VEC2U16( OVERLAY_WIDTH, OVERLAY_HEIGHT ), TermLayerDepth_MODAL );
+    if ( widget->layer ) term_layer_move( widget->layer, SCREENPOS( 2, 3 ) );
+    widget->shown = false;
+
+    event_subscribe( (struct Widget *)widget, EventType_USER_INPUT );
+}
+
+
+static void disable_callback( struct Widget *base )
+{
+    struct WidgetInputLatency *const widget = (struct WidgetInputLatency *)base;
+    timer_wheel_cancel( &widget->refreshTimer );
+    term_layer_destroy( widget->layer );
+    widget->layer = NULL;
+    widget->shown = false;
+
+    event_unsubscribe( (struct Widget *)widget, EventType_USER_INPUT );
+}
+
+
+struct Widget *widget_input_latency_create( void )
+{
+    struct WidgetInputLatency *const widget = calloc( 1, sizeof( struct WidgetInputLatency ) );
+    if ( !widget ) return NULL;
+
+    widget->base.name = "InputLatency";
+    widget->base.enabledScenes = UIScene_ALL;
+    widget->base.enableCb = enable_callback;
+    widget->base.disableCb = disable_callback;
+
+    event_register( widget, on_event_callback );
+
+    return (struct Widget *)widget;
+}
@@ -38,12 +38,15 @@ static void enable_callback( struct Widget *base )
 {
     struct WidgetMousePos *widget = (struct WidgetMousePos *)base;
     draw_mouse_pos( widget, SCREENPOS( 0, 0 ) );
+
+    term_add_cosmetic_area( rect_get_ul_corner( &widget->rect ), widget->rect.size );
 }
 
 
 static void disable_callback( struct Widget *base )
 {
     struct WidgetMousePos *widget = (struct WidgetMousePos *)base;
+    term_remove_cosmetic_area( rect_get_ul_corner( &widget->rect ), widget->rect.size );
     rect_clear( &widget->rect );
 }
 
@@ -7,67 +7,26 @@
 #include <stdlib.h>
 
 
-struct WidgetPegTracking
+enum // Constants
 {
-    struct Widget base;
-
-    struct Character charactersSave[2][4];
-    struct Character pegSave[2][4];
-    screenpos pos;
-    struct Peg peg;
+    PEG_TRACKING_WIDTH = 4,
+    PEG_TRACKING_HEIGHT = 2
 };
 
 
-static void write_saved_content_at_pos( struct WidgetPegTracking *widget )
-{
-    for ( usize y = 0; y < 2 && widget->pos.y + y <= GAME_SIZE_HEIGHT; ++y )
-    {
-        for ( usize x = 0; x < 4 && widget->pos.x + x <= GAME_SIZE_WIDTH; ++x )
-        {
-            struct Character const pegPart = widget->pegSave[y][x];
-            screenpos const pos = SCREENPOS( widget->pos.x + x, widget->pos.y + y );
-
-            // If the character on screen is different than the peg part than we expect, we shouldn't
-            // override the character with our save, because our save is obsolete.
-            if ( !character_equals( term_character_buffered_at_pos( pos ), pegPart ) ) continue;
-
-            struct Character const character = widget->charactersSave[y][x];
-            cursor_update_pos( pos );
-            style_update( character.style );
-            term_write( L"%lc", character.unicode );
-        }
-    }    
-}
-
-
-static void save_content_at_pos( struct WidgetPegTracking *widget, bool saveCharacter )
+// The dragged peg is drawn on a layer over the rest of the screen, that follows the mouse.
+struct WidgetPegTracking
 {
-    for ( usize y = 0; y < 2 && widget->pos.y + y <= GAME_SIZE_HEIGHT; ++y )
-    {
-        for ( usize x = 0; x < 4 && widget->pos.x + x <= GAME_SIZE_WIDTH; ++x )
-        {
-            screenpos pos = SCREENPOS( widget->pos.x + x, widget->pos.y + y );
-            if ( saveCharacter )
-            {
-                widget->charactersSave[y][x] = term_character_buffered_at_pos( pos );
-            }
-            else
-            {
-                widget->pegSave[y][x] = term_character_buffered_at_pos( pos );
-            }
-        }
-    }
-}
+    struct Widget base;
 
+    struct TermLayer *layer;
+    struct Peg peg;
+};
 
 
 static void update_tracking( struct WidgetPegTracking *widget, screenpos pos )
 {
-    write_saved_content_at_pos( widget );
-    widget->pos = pos;
-
-    save_content_at_pos( widget, true );
-    peg_write_4x2( widget->pos, widget->peg );
+    term_layer_move( widget->layer, pos );
 }
 
 
@@ -76,22 +35,17 @@ static void disable_tracking( struct WidgetPegTracking *widget )
     if ( widget->peg.id == PegId_EMPTY ) return;
 
     widget->peg.id = PegId_EMPTY;
-    write_saved_content_at_pos( widget );
+    term_layer_hide( widget->layer );
 }
 
 
 static void enable_tracking( struct WidgetPegTracking *widget, struct Peg const peg )
 {
-    if ( widget->peg.id != PegId_EMPTY )
-    {
-        disable_tracking( widget );
-    }
-    widget->pos = mouse_pos();
     widget->peg = peg;
 
-    save_content_at_pos( widget, true );
-    peg_write_4x2( widget->pos, widget->peg );
-    save_content_at_pos( widget, false );
+    term_layer_set_content( widget->layer, peg_sprite_4x2( peg ) );
+    term_layer_move( widget->layer, mouse_pos() );
+    term_layer_show( widget->layer );
 }
 
 
@@ -103,7 +57,7 @@ static enum EventPropagation on_event_callback( void *subscriber, struct Event c
     {
         case EventType_MOUSE_MOVED:
         {
-            if ( widget->peg.id != PegId_EMPTY )
+            if ( widget->layer && widget->peg.id != PegId_EMPTY )
             {
                 update_tracking( widget, event->mouseMoved.pos );
             }
@@ -112,7 +66,7 @@ static enum EventPropagation on_event_callback( void *subscriber, struct Event c
 
         case EventType_PEG_SELECTED:
         {
-            enable_tracking( widget, event->peg.peg );
+            if ( widget->layer ) enable_tracking( widget, event->peg.peg );
             break;
         }
         case EventType_PEG_UNSELECTED:
@@ -131,6 +85,8 @@ static void enable_callback( struct Widget *base )
 {
     struct WidgetPegTracking *const widget = (struct WidgetPegTracking *)base;
     widget->peg.id = PegId_EMPTY;
+    // Without its layer, the widget stays enabled but the dragged peg isn't displayed.
+    widget->layer = term_layer_create( VEC2U16( PEG_TRACKING_WIDTH, PEG_TRACKING_HEIGHT ), TermLayerDepth_CURSOR );
 
     event_subscribe( (struct Widget *)widget, EventType_MaskAll );
 }
@@ -143,6 +99,8 @@ static void disable_callback( struct Widget *base )
     {
         disable_tracking( widget );
     }
+    term_layer_destroy( widget->layer );
+    widget->layer = NULL;
 
     event_unsubscribe( (struct Widget *)widget, EventType_MaskAll );
 }
@@ -3,9 +3,16 @@
 #include "time_units.h"
 #include "terminal/terminal.h"
 #include "events.h"
+#include "timer_wheel.h"
 
 #include <stdlib.h>
 
+enum // Constants
+{
+    TIMER_DISPLAY_WIDTH = 8 // hh:mm:ss
+};
+
+
 enum TimerStatus
 {
     TimerStatus_NOT_STARTED,
@@ -19,17 +26,26 @@ struct WidgetTimer
     struct Widget base;
 
     enum TimerStatus status;
+    // While running, the duration is counted from the start. Otherwise it is the one kept when paused.
+    nsecond startTimestamp;
     nsecond totalDuration;
-    nsecond lastUpdateTimestamp;
+    // Due on the next second, when the display changes.
+    struct Timer secondTimer;
     struct Rect box;
     screenpos dispPos;
     struct Style style;
 };
 
 
-static void draw_update( struct WidgetTimer const *widget )
+static nsecond elapsed_duration( struct WidgetTimer const *widget, nsecond const now )
+{
+    return ( widget->status == TimerStatus_RUNNING ) ? now - widget->startTimestamp : widget->totalDuration;
+}
+
+
+static void draw_update( struct WidgetTimer const *widget, nsecond const now )
 {
-    second const totalDuration = time_nsec_to_sec( widget->totalDuration );
+    second const totalDuration = time_nsec_to_sec( elapsed_duration( widget, now ) );
     hour const hours     = ( totalDuration / 3600 );
     minute const minutes = ( totalDuration % 3600 ) / 60;
     second const seconds = totalDuration % 60;
@@ -40,13 +56,35 @@ static void draw_update( struct WidgetTimer const *widget )
 }
 
 
+static void on_second_elapsed( void *userData, nsecond now );
+
+
+static void schedule_next_second( struct WidgetTimer *widget, nsecond const now )
+{
+    nsecond const duration = elapsed_duration( widget, now );
+    nsecond const untilNextSecond = Time_SEC_IN_NSEC - ( duration % Time_SEC_IN_NSEC );
+    timer_wheel_schedule( &widget->secondTimer, now + untilNextSecond, on_second_elapsed, widget );
+}
+
+
+static void on_second_elapsed( void *userData, nsecond const now )
+{
+    struct WidgetTimer *widget = (struct WidgetTimer *)userData;
+    assert( widget->status == TimerStatus_RUNNING );
+
+    draw_update( widget, now );
+    schedule_next_second( widget, now );
+}
+
+
 static void start_timer( struct WidgetTimer *widget )
 {
     if ( widget->status == TimerStatus_NOT_STARTED )
     {
-        widget->lastUpdateTimestamp = time_get_timestamp_nsec();
+        widget->startTimestamp = time_get_timestamp_nsec();
         widget->totalDuration = 0;
         widget->status = TimerStatus_RUNNING;
+        schedule_next_second( widget, widget->startTimestamp );
     }
 }
 
@@ -55,6 +93,7 @@ static void reset_timer( struct WidgetTimer *widget )
 {
     if ( widget->status == TimerStatus_RUNNING || widget->status == TimerStatus_PAUSED )
     {
+        timer_wheel_cancel( &widget->secondTimer );
         widget->totalDuration = 0;
         widget->status = TimerStatus_NOT_STARTED;
     }
@@ -68,6 +107,8 @@ static void pause_timer( struct WidgetTimer *widget )
 
     if ( widget->status == TimerStatus_RUNNING )
     {
+        timer_wheel_cancel( &widget->secondTimer );
+        widget->totalDuration = time_get_timestamp_nsec() - widget->startTimestamp;
         widget->status = TimerStatus_PAUSED;
     }
 }
@@ -77,8 +118,9 @@ static void pause_timer( struct WidgetTimer *widget )
 {
     if ( widget->status == TimerStatus_PAUSED )
     {
-        widget->lastUpdateTimestamp = time_get_timestamp_nsec();
+        widget->startTimestamp = time_get_timestamp_nsec() - widget->totalDuration;
         widget->status = TimerStatus_RUNNING;
+        schedule_next_second( widget, widget->startTimestamp + widget->totalDuration );
     }
 }*/
 
@@ -92,13 +134,13 @@ static enum EventPropagation on_event_callback( void *subscriber, struct Event c
         reset_timer( widget );
         start_timer( widget );
         widget->style = STYLE( FGColor_WHITE );
-        draw_update( widget );
+        draw_update( widget, time_get_timestamp_nsec() );
 	}
 	else if ( event->type == EventType_GAME_LOST || event->type == EventType_GAME_WON )
 	{
         pause_timer( widget );
         widget->style = STYLE_WITH_ATTR( FGColor_WHITE, Attr_FAINT );
-        draw_update( widget );
+        draw_update( widget, time_get_timestamp_nsec() );
 	}
     return EventPropagation_CONTINUE;
 }
@@ -108,36 +150,22 @@ static void enable_callback( struct Widget *base )
 {
     struct WidgetTimer *widget = (struct WidgetTimer *)base;
     rect_draw_borders( &widget->box, L"Timer" );
-    draw_update( widget );
-}
 
+    nsecond const now = time_get_timestamp_nsec();
+    draw_update( widget, now );
+    if ( widget->status == TimerStatus_RUNNING ) schedule_next_second( widget, now );
 
-static void disable_callback( struct Widget *base )
-{
-    struct WidgetTimer *widget = (struct WidgetTimer *)base;
-    rect_clear( &widget->box );
+    term_add_cosmetic_area( widget->dispPos, VEC2U16( TIMER_DISPLAY_WIDTH, 1 ) );
 }
 
 
-static void frame_callback( struct Widget *base )
+static void disable_callback( struct Widget *base )
 {
     struct WidgetTimer *widget = (struct WidgetTimer *)base;
-
-    if ( widget->status != TimerStatus_RUNNING )
-        return;
-
-    second const oldDuration = time_nsec_to_sec( widget->totalDuration );
-    nsecond const newTimestamp = time_get_timestamp_nsec();
-    nsecond const elapsedTime = newTimestamp - widget->lastUpdateTimestamp;
-
-    widget->totalDuration += elapsedTime;
-    widget->lastUpdateTimestamp = newTimestamp;
-
-    second const newDuration = time_nsec_to_sec( widget->totalDuration );
-    if ( oldDuration != newDuration )
-    {
-        draw_update( widget );
-    }
+    // Still running meanwhile, only the display stops.
+    timer_wheel_cancel( &widget->secondTimer );
+    term_remove_cosmetic_area( widget->dispPos, VEC2U16( TIMER_DISPLAY_WIDTH, 1 ) );
+    rect_clear( &widget->box );
 }
 
 
@@ -150,7 +178,6 @@ struct Widget *widget_timer_create( void )
     widget->base.enabledScenes = UIScene_IN_GAME;
     widget->base.enableCb = enable_callback;
     widget->base.disableCb = disable_callback;
-    widget->base.frameCb = frame_callback;
 
     // Widget specific    
     screenpos const boxUL = SCREENPOS( 95, 2 );